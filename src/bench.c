@@ -0,0 +1,945 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "hashids.h"
+
+/* a 90+ character custom alphabet */
+#define BENCH_LONG_ALPHABET "abcdefghijklmnopqrstuvwxyz" \
+                            "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
+                            "1234567890" \
+                            "!#$%&()*+,-./:;<=>?@[]^_{|}~"
+
+/* iteration scale, set from the command line */
+size_t scale = 1;
+
+/* keeps the optimizer from dropping results */
+volatile size_t sink;
+
+double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+void
+report(const char *name, size_t ops, double elapsed)
+{
+    printf("%-48s %12.1f ns/op %14.0f ops/s\n", name, elapsed / ops,
+        ops / (elapsed / 1e9));
+}
+
+void
+bench_init(const char *name, const char *salt, size_t min_hash_length,
+    const char *alphabet, unsigned int tables)
+{
+    hashids_t *hashids;
+    size_t i, ops = 20000 * scale;
+    double start;
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        hashids = hashids_init5(salt, min_hash_length, alphabet, NULL,
+            tables);
+        sink += hashids->alphabet_length;
+        hashids_free(hashids);
+    }
+    report(name, ops, now() - start);
+}
+
+void
+bench_derive(const char *name, const char *alphabet)
+{
+    hashids_t *template, *hashids;
+    size_t i, ops = 20000 * scale;
+    char salts[256][32];
+    double start;
+
+    template = hashids_init3("", 0, alphabet);
+    for (i = 0; i < 256; ++i) {
+        snprintf(salts[i], sizeof(salts[i]), "tenant salt %lu",
+            (unsigned long)i);
+    }
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        hashids = hashids_derive(template, salts[i % 256]);
+        sink += hashids->alphabet_length;
+        hashids_free(hashids);
+    }
+    report(name, ops, now() - start);
+
+    hashids_free(template);
+}
+
+void
+bench_encode(const char *name, const char *salt, unsigned int tables)
+{
+    hashids_t *hashids;
+    unsigned long long numbers[3] = {48213ull, 7ull, 0ull};
+    size_t i, ops = 1000000 * scale;
+    char buffer[64], label[64];
+    double start;
+
+    hashids = hashids_init5(salt, 0, HASHIDS_DEFAULT_ALPHABET, NULL, tables);
+
+    snprintf(label, sizeof(label), "hashids_encode x 3 (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        numbers[2] = 1000000000ull + i * 31;
+        sink += hashids_encode(hashids, buffer, 3, numbers);
+    }
+    report(label, ops, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_decode x 3 (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode(hashids, buffer, numbers, 3);
+    }
+    report(label, ops, now() - start);
+
+    hashids_free(hashids);
+}
+
+void
+bench_batch(const char *name, size_t min_hash_length)
+{
+    hashids_t *hashids;
+    unsigned long long *numbers, seed = 1;
+    unsigned char *valid;
+    size_t i, ops = 200 * scale, count = 4096;
+    char *batch, buffer[64], label[64];
+    double start;
+
+    hashids = hashids_init2("this is my salt", min_hash_length);
+    numbers = (unsigned long long *)malloc(count * sizeof(*numbers));
+    batch = (char *)malloc(count * 32);
+    valid = (unsigned char *)malloc(count);
+    for (i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = seed >> 24;
+    }
+
+    snprintf(label, sizeof(label), "hashids_encode_one x N (%s)", name);
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_encode_one(hashids, buffer, numbers[i % count]);
+    }
+    report(label, ops * count, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_encode_one_batch (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_one_batch(hashids, batch, 32, numbers, count);
+    }
+    report(label, ops * count, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_decode_safe x N (%s)", name);
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_decode_safe(hashids, batch + i % count * 32, numbers,
+            1);
+    }
+    report(label, ops * count, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_decode_one_batch (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_one_batch(hashids, batch, 32, count, numbers,
+            valid);
+    }
+    report(label, ops * count, now() - start);
+
+    free(valid);
+    free(batch);
+    free(numbers);
+    hashids_free(hashids);
+}
+
+void
+bench_parallel(void)
+{
+    hashids_t *hashids;
+    hashids_pool_t *pool;
+    unsigned long long *numbers, seed = 1;
+    unsigned char *valid;
+    size_t i, threads, cpus, ops = 20 * scale, count = 65536;
+    char *batch, label[64];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+    numbers = (unsigned long long *)malloc(count * sizeof(*numbers));
+    valid = (unsigned char *)malloc(count);
+    batch = (char *)malloc(count * 32);
+    for (i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = seed >> 24;
+    }
+
+    /* 1, 2, 4, ... threads, up to the CPU count */
+    cpus = sysconf(_SC_NPROCESSORS_ONLN) > 0
+        ? (size_t)sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    for (threads = 1; /* empty */; threads *= 2) {
+        if (threads > cpus) {
+            threads = cpus;
+        }
+        pool = hashids_pool_init(threads);
+
+        snprintf(label, sizeof(label), "hashids_encode_one_parallel (%lu "
+            "threads)", (unsigned long)threads);
+        start = now();
+        for (i = 0; i < ops; ++i) {
+            sink += hashids_encode_one_parallel(hashids, batch, 32, numbers,
+                count, hashids_pool_executor(pool));
+        }
+        report(label, ops * count, now() - start);
+
+        snprintf(label, sizeof(label), "hashids_decode_one_parallel (%lu "
+            "threads)", (unsigned long)threads);
+        start = now();
+        for (i = 0; i < ops; ++i) {
+            sink += hashids_decode_one_parallel(hashids, batch, 32, count,
+                numbers, valid, hashids_pool_executor(pool));
+        }
+        report(label, ops * count, now() - start);
+
+        hashids_pool_free(pool);
+        if (threads == cpus) {
+            break;
+        }
+    }
+
+    free(batch);
+    free(valid);
+    free(numbers);
+    hashids_free(hashids);
+}
+
+void
+bench_memo(void)
+{
+    hashids_t *hashids;
+    hashids_memo_t *memo;
+    hashids_memo_stats_t stats;
+    unsigned long long *numbers, seed = 1;
+    unsigned char *valid;
+    size_t i, ops = 200 * scale, count = 4096;
+    char *batch, buffer[64];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+    memo = hashids_memo_init(hashids, 1024);
+    numbers = (unsigned long long *)malloc(count * sizeof(*numbers));
+    valid = (unsigned char *)malloc(count);
+    batch = (char *)malloc(count * 32);
+
+    /* skewed - 9 in 10 from 64 hot IDs */
+    for (i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = (seed >> 33) % 10 ? (seed >> 40) % 64 * 7919
+            : seed >> 24;
+    }
+    hashids_encode_one_batch(hashids, batch, 32, numbers, count);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_encode_one(hashids, buffer, numbers[i % count]);
+    }
+    report("hashids_encode_one x N (skewed)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_memo_encode(memo, buffer, 1, numbers + i % count);
+    }
+    report("hashids_memo_encode x N (skewed)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_decode_safe(hashids, batch + i % count * 32, numbers,
+            1);
+    }
+    report("hashids_decode_safe x N (skewed)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_memo_decode(memo, batch + i % count * 32, numbers, 1);
+    }
+    report("hashids_memo_decode x N (skewed)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_one_batch(hashids, batch, 32, count, numbers,
+            valid);
+    }
+    report("hashids_decode_one_batch (skewed)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_memo_decode_one_batch(memo, batch, 32, count,
+            numbers, valid);
+    }
+    report("hashids_memo_decode_one_batch (skewed)", ops * count,
+        now() - start);
+
+    hashids_memo_stats(memo, &stats);
+    printf("memo: %llu/%llu encode hits, %llu/%llu decode hits, "
+        "%llu evictions, %llu duplicates\n", stats.encode_hits,
+        stats.encode_hits + stats.encode_misses, stats.decode_hits,
+        stats.decode_hits + stats.decode_misses, stats.evictions,
+        stats.duplicates);
+
+    free(batch);
+    free(valid);
+    free(numbers);
+    hashids_memo_free(memo);
+    hashids_free(hashids);
+}
+
+void
+bench_range(const char *name, size_t min_hash_length)
+{
+    hashids_t *hashids;
+    hashids_range_t *range;
+    size_t i, ops = 1000000 * scale;
+    char buffer[64], label[64];
+    double start;
+
+    hashids = hashids_init2("this is my salt", min_hash_length);
+
+    snprintf(label, sizeof(label), "hashids_encode_one x N (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_one(hashids, buffer, 1000000000ull + i);
+    }
+    report(label, ops, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_range_next (%s)", name);
+    start = now();
+    range = hashids_range_init(hashids, 1000000000ull);
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_range_next(range, buffer);
+    }
+    hashids_range_free(range);
+    report(label, ops, now() - start);
+
+    hashids_free(hashids);
+}
+
+void
+bench_encoder(void)
+{
+    hashids_t *hashids;
+    hashids_encoder_t *encoder;
+    unsigned long long numbers[3] = {48213ull, 7ull, 0ull};
+    size_t i, ops = 1000000 * scale;
+    char buffer[64];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        numbers[2] = 1000000000ull + i * 31;
+        sink += hashids_encode(hashids, buffer, 3, numbers);
+    }
+    report("hashids_encode (tenant, shard, row)", ops, now() - start);
+
+    encoder = hashids_encoder_init(hashids, 2, numbers);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        numbers[2] = 1000000000ull + i * 31;
+        sink += hashids_encoder_encode(encoder, buffer, 1, numbers + 2);
+    }
+    report("hashids_encoder_encode (row)", ops, now() - start);
+    hashids_encoder_free(encoder);
+
+    hashids_free(hashids);
+}
+
+size_t
+bench_read(void *ctx, size_t index, unsigned long long *numbers,
+    size_t numbers_max)
+{
+    size_t count = 100000 - index < numbers_max ? 100000 - index : numbers_max;
+
+    memcpy(numbers, (unsigned long long *)ctx + index,
+        count * sizeof(*numbers));
+    return count;
+}
+
+int
+bench_write(void *ctx, const char *data, size_t length)
+{
+    (void)ctx;
+    sink += length + data[0];
+    return 0;
+}
+
+int
+bench_emit(void *ctx, unsigned long long number)
+{
+    (void)ctx;
+    sink += number;
+    return 0;
+}
+
+void
+bench_stream(void)
+{
+    hashids_t *hashids;
+    hashids_stream_decoder_t *decoder;
+    hashids_stream_source_t source = {bench_read, NULL};
+    hashids_stream_sink_t output = {bench_write, NULL};
+    hashids_number_sink_t numbers_output = {bench_emit, NULL};
+    unsigned long long *numbers, seed = 1;
+    size_t i, j, length, ops = 20 * scale, count = 100000;
+    char *buffer;
+    double start;
+
+    hashids = hashids_init("this is my salt");
+    numbers = (unsigned long long *)malloc(count * sizeof(*numbers));
+    for (i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = seed >> 40;
+    }
+    source.ctx = numbers;
+    buffer = (char *)malloc(hashids_estimate_encoded_size(hashids, count,
+        numbers));
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode(hashids, buffer, count, numbers);
+    }
+    report("hashids_encode (10^5 numbers)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_stream(hashids, &source, &output);
+    }
+    report("hashids_encode_stream (10^5 numbers)", ops, now() - start);
+
+    length = hashids_encode(hashids, buffer, count, numbers);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode(hashids, buffer, numbers, count);
+    }
+    report("hashids_decode (10^5 numbers)", ops, now() - start);
+
+    decoder = hashids_stream_decoder_init(hashids, &numbers_output);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        for (j = 0; j < length; j += 1500) {
+            hashids_stream_decoder_feed(decoder, buffer + j,
+                length - j < 1500 ? length - j : 1500);
+        }
+        sink += hashids_stream_decoder_finish(decoder);
+    }
+    report("hashids_stream_decoder_feed (1500 bytes)", ops, now() - start);
+    hashids_stream_decoder_free(decoder);
+
+    free(buffer);
+    free(numbers);
+    hashids_free(hashids);
+}
+
+void
+bench_bounded(void)
+{
+    hashids_t *hashids;
+    unsigned long long numbers[4] = {48213ull, 7ull, 1234567ull, 0ull};
+    size_t i, ops = 1000000 * scale;
+    char buffer[64], *hostile;
+    double start;
+
+    hashids = hashids_init("this is my salt");
+    hashids_encode(hashids, buffer, 3, numbers);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_safe(hashids, buffer, numbers, 4);
+    }
+    report("hashids_decode_safe (3 numbers)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_bounded(hashids, buffer, numbers, 4, 64);
+    }
+    report("hashids_decode_bounded (3 numbers)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_into(hashids, buffer, numbers, 4);
+    }
+    report("hashids_decode_into (3 numbers)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_numbers_count(hashids, buffer);
+        sink += hashids_decode_safe(hashids, buffer, numbers, 4);
+    }
+    report("hashids_numbers_count + decode_safe (3 numbers)", ops,
+        now() - start);
+
+    /* a lottery followed by one long digit run */
+    hostile = (char *)malloc(10001);
+    memset(hostile, buffer[1], 10000);
+    hostile[0] = buffer[0];
+    hostile[10000] = '\0';
+    ops /= 100;
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_safe(hashids, hostile, numbers, 4);
+    }
+    report("hashids_decode_safe (10^4 digits)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_bounded(hashids, hostile, numbers, 4, 64);
+    }
+    report("hashids_decode_bounded (10^4 digits)", ops, now() - start);
+
+    free(hostile);
+    hashids_free(hashids);
+}
+
+void
+bench_fanout(void)
+{
+    hashids_t *instances[32];
+    unsigned long long numbers[3] = {48213ull, 7ull, 1234567ull};
+    size_t i, j, ops = 100000 * scale;
+    char salt[32], buffer[32 * 64];
+    double start;
+
+    for (i = 0; i < 32; ++i) {
+        sprintf(salt, "tenant salt %u", (unsigned int)i);
+        instances[i] = hashids_init2(salt, 8);
+    }
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        for (j = 0; j < 32; ++j) {
+            sink += hashids_encode(instances[j], buffer + j * 64, 3, numbers);
+        }
+    }
+    report("hashids_encode x 32 salts", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_fanout(instances, 32, buffer,
+            64, 3, numbers);
+    }
+    report("hashids_encode_fanout (32 salts)", ops, now() - start);
+
+    for (i = 0; i < 32; ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+bench_multi(void)
+{
+    hashids_t *instances[3];
+    hashids_multi_t *multi;
+    unsigned long long numbers[4] = {48213ull, 7ull, 1234567ull, 0ull};
+    size_t i, j, index, ops = 1000000 * scale;
+    char buffer[64];
+    double start;
+
+    /* the newest first - hashes from the oldest are the worst case */
+    instances[0] = hashids_init("this is my new salt");
+    instances[1] = hashids_init2("this is my newer salt", 16);
+    instances[2] = hashids_init("this is my salt");
+    multi = hashids_multi_init(instances, 3);
+    hashids_encode(instances[2], buffer, 3, numbers);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        for (j = 0; j < 3; ++j) {
+            if (hashids_decode_safe(instances[j], buffer, numbers, 4)) {
+                break;
+            }
+        }
+        sink += j;
+    }
+    report("hashids_decode_safe x 3 configs", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_multi_decode(multi, buffer, numbers, 4, &index);
+    }
+    report("hashids_multi_decode (3 configs)", ops, now() - start);
+
+    hashids_multi_free(multi);
+    for (i = 0; i < 3; ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+bench_registry(void)
+{
+    hashids_registry_t *registry;
+    hashids_registry_entry_t *entry;
+    size_t i, ops = 1000000 * scale;
+    char salts[64][32];
+    double start;
+
+    registry = hashids_registry_init(1024);
+    for (i = 0; i < 64; ++i) {
+        snprintf(salts[i], sizeof(salts[i]), "tenant salt %lu",
+            (unsigned long)i);
+        hashids_registry_release(hashids_registry_acquire(registry, salts[i],
+            0, HASHIDS_DEFAULT_ALPHABET));
+    }
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        entry = hashids_registry_acquire(registry, salts[i % 64], 0,
+            HASHIDS_DEFAULT_ALPHABET);
+        sink += entry->hashids->alphabet_length;
+        hashids_registry_release(entry);
+    }
+    report("hashids_registry_acquire + release (hit)", ops, now() - start);
+
+    hashids_registry_free(registry);
+}
+
+void
+bench_file(void)
+{
+    hashids_t *instances[256];
+    hashids_file_t *file;
+    char path[] = "/tmp/hashids-bench-XXXXXX", salt[32];
+    size_t i, j, ops = 200 * scale;
+    double start;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+
+    start = now();
+    for (j = 0; j < ops; ++j) {
+        for (i = 0; i < 256; ++i) {
+            snprintf(salt, sizeof(salt), "tenant salt %lu", (unsigned long)i);
+            instances[i] = hashids_init3(salt, 8, HASHIDS_DEFAULT_ALPHABET);
+        }
+        if (j + 1 < ops) {
+            for (i = 0; i < 256; ++i) {
+                hashids_free(instances[i]);
+            }
+        }
+    }
+    report("256 x hashids_init3", ops, now() - start);
+
+    hashids_file_save(path, instances, 256);
+
+    start = now();
+    for (j = 0; j < ops; ++j) {
+        file = hashids_file_open(path);
+        sink += hashids_file_get(file, 255)->alphabet_length;
+        hashids_file_close(file);
+    }
+    report("hashids_file_open (256 instances)", ops, now() - start);
+
+    unlink(path);
+    for (i = 0; i < 256; ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+bench_dict(void)
+{
+    hashids_t *hashids;
+    hashids_dict_t *dict;
+    unsigned long long *numbers, number, seed = 1, count = 1 << 20;
+    char path[] = "/tmp/hashids-bench-XXXXXX", *hashes, buffer[64];
+    size_t i, ops = 1000000 * scale, batch = 4096;
+    double start;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+
+    hashids = hashids_init("this is my salt");
+    numbers = (unsigned long long *)malloc(batch * sizeof(*numbers));
+    hashes = (char *)malloc(batch * 32);
+
+    /* scattered over the whole dictionary */
+    for (i = 0; i < batch; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = (seed >> 33) % count;
+        hashids_encode_one(hashids, hashes + i * 32, numbers[i]);
+    }
+
+    start = now();
+    hashids_dict_save(path, hashids, count);
+    report("hashids_dict_save (2^20 numbers)", 1, now() - start);
+
+    start = now();
+    dict = hashids_dict_open(path);
+    report("hashids_dict_open (2^20 numbers)", 1, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_one(hashids, buffer, numbers[i % batch]);
+    }
+    report("hashids_encode_one x N (< 2^20)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_dict_encode(dict, buffer, numbers[i % batch]);
+    }
+    report("hashids_dict_encode (< 2^20)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_safe(hashids, hashes + i % batch * 32,
+            &number, 1);
+    }
+    report("hashids_decode_safe x N (< 2^20)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_dict_decode(dict, hashes + i % batch * 32, &number);
+    }
+    report("hashids_dict_decode (< 2^20)", ops, now() - start);
+
+    hashids_dict_close(dict);
+    unlink(path);
+    free(hashes);
+    free(numbers);
+    hashids_free(hashids);
+}
+
+void
+bench_hex(void)
+{
+    hashids_t *hashids;
+    size_t i, ops = 1000000 * scale;
+    char buffer[64], output[32];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_hex(hashids, buffer, "DEADBEEFC0FFEE");
+    }
+    report("hashids_encode_hex (14 digits)", ops, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_hex(hashids, buffer, output);
+    }
+    report("hashids_decode_hex (14 digits)", ops, now() - start);
+
+    hashids_free(hashids);
+}
+
+void
+bench_big(const char *name, const char *hex)
+{
+    hashids_t *hashids;
+    size_t i, ops = 200000 * scale;
+    char buffer[256], output[256], label[64];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+
+    snprintf(label, sizeof(label), "hashids_encode_hex_big (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_hex_big(hashids, buffer, hex);
+    }
+    report(label, ops, now() - start);
+
+    snprintf(label, sizeof(label), "hashids_decode_hex_big (%s)", name);
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_hex_big(hashids, buffer, output,
+            sizeof(output));
+    }
+    report(label, ops, now() - start);
+
+    hashids_free(hashids);
+}
+
+void
+bench_uuid(void)
+{
+    hashids_t *hashids;
+    unsigned char *uuids, uuid[HASHIDS_UUID_SIZE];
+    size_t i, ops = 200 * scale, count = 1024;
+    char *batch, buffer[HASHIDS_UUID_BUFFER_SIZE];
+    double start;
+
+    hashids = hashids_init("this is my salt");
+    uuids = (unsigned char *)malloc(count * HASHIDS_UUID_SIZE);
+    batch = (char *)malloc(count * HASHIDS_UUID_BUFFER_SIZE);
+    for (i = 0; i < count * HASHIDS_UUID_SIZE; ++i) {
+        uuids[i] = (unsigned char)rand();
+    }
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_encode_bytes(hashids, buffer,
+            uuids + i % count * HASHIDS_UUID_SIZE, HASHIDS_UUID_SIZE);
+    }
+    report("hashids_encode_bytes (16 bytes)", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_encode_uuid(hashids, buffer,
+            uuids + i % count * HASHIDS_UUID_SIZE);
+    }
+    report("hashids_encode_uuid", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_encode_uuid_batch(hashids, batch,
+            HASHIDS_UUID_BUFFER_SIZE, uuids, count);
+    }
+    report("hashids_encode_uuid_batch (per UUID)", ops * count,
+        now() - start);
+
+    start = now();
+    for (i = 0; i < ops * count; ++i) {
+        sink += hashids_decode_uuid(hashids,
+            batch + i % count * HASHIDS_UUID_BUFFER_SIZE, uuid);
+    }
+    report("hashids_decode_uuid", ops * count, now() - start);
+
+    start = now();
+    for (i = 0; i < ops; ++i) {
+        sink += hashids_decode_uuid_batch(hashids, batch,
+            HASHIDS_UUID_BUFFER_SIZE, count, uuids);
+    }
+    report("hashids_decode_uuid_batch (per UUID)", ops * count,
+        now() - start);
+
+    free(batch);
+    free(uuids);
+    hashids_free(hashids);
+}
+
+int
+main(int argc, char **argv)
+{
+    int ch;
+
+    static const struct option longopts[] = {
+        {"scale", required_argument, NULL, 's'},
+        {NULL, 0, NULL, 0}
+    };
+
+    /* parse command line options */
+    while ((ch = getopt_long(argc, argv, "+s:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 's':
+                scale = strtoul(optarg, NULL, 10);
+                if (!scale) {
+                    scale = 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s scale]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* initialization */
+    bench_init("hashids_init3 (default alphabet)", "this is my salt", 0,
+        HASHIDS_DEFAULT_ALPHABET, 0);
+    bench_init("hashids_init3 (90+ char alphabet)", "this is my salt", 0,
+        BENCH_LONG_ALPHABET, 0);
+    bench_init("hashids_init3 (default alphabet, min length 16)",
+        "this is my salt", 16, HASHIDS_DEFAULT_ALPHABET, 0);
+    bench_init("hashids_init3 (default alphabet, min length 32)",
+        "this is my salt", 32, HASHIDS_DEFAULT_ALPHABET, 0);
+    bench_init("hashids_init5 (min length 16, padding templates)",
+        "this is my salt", 16, HASHIDS_DEFAULT_ALPHABET, HASHIDS_TABLE_PAD);
+    bench_init("hashids_init5 (min length 32, padding templates)",
+        "this is my salt", 32, HASHIDS_DEFAULT_ALPHABET, HASHIDS_TABLE_PAD);
+    bench_init("hashids_init3 (90+ char alphabet, 64 char salt)",
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+        0, BENCH_LONG_ALPHABET, 0);
+    bench_init("hashids_init5 (90+ alphabet, 64 salt, shuffle table)",
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+        0, BENCH_LONG_ALPHABET, HASHIDS_TABLE_SHUFFLE);
+    bench_derive("hashids_derive (default alphabet)", HASHIDS_DEFAULT_ALPHABET);
+    bench_derive("hashids_derive (90+ char alphabet)", BENCH_LONG_ALPHABET);
+
+    /* encode & decode */
+    bench_encode("15 char salt", "this is my salt", 0);
+    bench_encode("15 char salt, shuffle table", "this is my salt",
+        HASHIDS_TABLE_SHUFFLE);
+    bench_encode("64 char salt",
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 0);
+    bench_encode("64 char salt, shuffle table",
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+        HASHIDS_TABLE_SHUFFLE);
+
+    /* hex & big numbers */
+    bench_hex();
+    bench_big("128 bits", "0123456789abcdef0123456789abcdef");
+    bench_big("256 bits",
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+
+    /* UUIDs */
+    bench_uuid();
+
+    /* batches of single numbers */
+    bench_batch("40 bits", 0);
+    bench_batch("40 bits, min length 16", 16);
+
+    /* threads */
+    bench_parallel();
+
+    /* hot IDs */
+    bench_memo();
+
+    /* consecutive numbers */
+    bench_range("no padding", 0);
+    bench_range("min length 16", 16);
+
+    /* shared prefixes */
+    bench_encoder();
+
+    /* huge tuples */
+    bench_stream();
+
+    /* untrusted input */
+    bench_bounded();
+
+    /* salt rotation */
+    bench_multi();
+
+    /* per-recipient tokens */
+    bench_fanout();
+
+    /* registry */
+    bench_registry();
+
+    /* mapped files */
+    bench_file();
+
+    /* bounded ID spaces */
+    bench_dict();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,573 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hashids.h"
+
+/* file format constants */
+#define HASHIDS_DICT_MAGIC "HASHDCT"
+#define HASHIDS_DICT_VERSION 1u
+#define HASHIDS_DICT_BYTE_ORDER 0x01020304u
+#define HASHIDS_DICT_ALIGNMENT 8u
+
+/* numbers a dictionary may hold - a pilot's top bit marks a direct slot */
+#define HASHIDS_DICT_MAX_COUNT 0x7FFFFFFFull
+#define HASHIDS_DICT_DIRECT 0x80000000u
+
+/* average keys per perfect hash bucket */
+#define HASHIDS_DICT_BUCKET_KEYS 4u
+
+/* larger buckets, or ones no pilot places, make the builder pick another
+   seed */
+#define HASHIDS_DICT_MAX_BUCKET 64u
+#define HASHIDS_DICT_SEEDS 16u
+#define HASHIDS_DICT_PILOTS 0x1000000u
+
+/*
+ * File layout (native byte order, 8-byte aligned sections):
+ *
+ *   header | offsets (count + 1) | strings | pilots (buckets) | ids (count)
+ *
+ * The hash of number n is strings[offsets[n], offsets[n + 1]). Decoding
+ * hashes the string into a bucket, whose pilot either names its slot
+ * directly or perturbs the hash into one, and ids[slot] is the candidate
+ * number - compared against its own string.
+ */
+struct hashids_dict_header_s {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned long long count;
+    unsigned long long size;
+    unsigned long long checksum;
+    unsigned long long seed;
+    unsigned long long buckets_count;
+    unsigned long long strings_size;
+};
+
+/* the dictionary "object" */
+struct hashids_dict_s {
+    void *map;
+    size_t map_size;
+
+    unsigned long long count;
+    unsigned long long seed;
+    unsigned long long buckets_count;
+    const uint32_t *offsets;
+    const char *strings;
+    const uint32_t *pilots;
+    const uint32_t *ids;
+};
+
+/* round up to the file alignment */
+static inline unsigned long long
+hashids_dict_align(unsigned long long offset)
+{
+    return (offset + HASHIDS_DICT_ALIGNMENT - 1)
+        & ~(unsigned long long)(HASHIDS_DICT_ALIGNMENT - 1);
+}
+
+/* word-at-a-time multiplicative hash - checksums & perfect hash keys */
+static unsigned long long
+hashids_dict_hash(unsigned long long hash, const char *data, size_t length)
+{
+    unsigned long long word;
+    size_t i;
+
+    for (; length >= sizeof(word); length -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        data += sizeof(word);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+
+    for (word = 0, i = length; i; --i) {
+        word = word << 8 | (unsigned char)data[i - 1];
+    }
+    hash = (hash ^ word ^ ((unsigned long long)length << 56))
+        * 0x9E3779B97F4A7C15ull;
+
+    return hash ^ (hash >> 29);
+}
+
+/* the bucket of a key */
+static inline unsigned long long
+hashids_dict_bucket(unsigned long long hash, unsigned long long buckets_count)
+{
+    return ((hash >> 32) * buckets_count) >> 32;
+}
+
+/* the slot of a key in a bucket with the given pilot */
+static inline unsigned long long
+hashids_dict_slot(unsigned long long hash, uint32_t pilot,
+    unsigned long long count)
+{
+    if (pilot & HASHIDS_DICT_DIRECT) {
+        return pilot & ~HASHIDS_DICT_DIRECT;
+    }
+
+    hash ^= (pilot + 1ull) * 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 31;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 29;
+
+    return ((hash >> 32) * count) >> 32;
+}
+
+/* section offsets of a dictionary - the file size */
+static inline unsigned long long
+hashids_dict_layout(unsigned long long count, unsigned long long strings_size,
+    unsigned long long buckets_count, unsigned long long *strings,
+    unsigned long long *pilots, unsigned long long *ids)
+{
+    *strings = hashids_dict_align(sizeof(struct hashids_dict_header_s)
+        + (count + 1) * sizeof(uint32_t));
+    *pilots = hashids_dict_align(*strings + strings_size);
+    *ids = *pilots + buckets_count * sizeof(uint32_t);
+
+    return hashids_dict_align(*ids + count * sizeof(uint32_t));
+}
+
+/* place every key - 0 if this seed doesn't work out */
+static int
+hashids_dict_place(const unsigned long long *hashes, unsigned long long count,
+    unsigned long long buckets_count, uint32_t *pilots, uint32_t *ids,
+    uint32_t *starts, uint32_t *keys, uint32_t *order, unsigned char *taken)
+{
+    unsigned long long i, j, k, size, slot, slots[HASHIDS_DICT_MAX_BUCKET],
+        free_slot;
+    uint32_t sizes[HASHIDS_DICT_MAX_BUCKET + 2], pilot, bucket;
+
+    /* keys by bucket */
+    memset(starts, 0, (buckets_count + 1) * sizeof(uint32_t));
+    for (i = 0; i < count; ++i) {
+        ++starts[hashids_dict_bucket(hashes[i], buckets_count) + 1];
+    }
+    for (i = 0; i < buckets_count; ++i) {
+        if (starts[i + 1] > HASHIDS_DICT_MAX_BUCKET) {
+            return 0;
+        }
+        starts[i + 1] += starts[i];
+    }
+    for (i = 0; i < count; ++i) {
+        keys[starts[hashids_dict_bucket(hashes[i], buckets_count)]++] =
+            (uint32_t)i;
+    }
+    for (i = buckets_count; i; --i) {
+        starts[i] = starts[i - 1];
+    }
+    starts[0] = 0;
+
+    /* buckets by size, largest first */
+    memset(sizes, 0, sizeof(sizes));
+    for (i = 0; i < buckets_count; ++i) {
+        ++sizes[HASHIDS_DICT_MAX_BUCKET - (starts[i + 1] - starts[i]) + 1];
+    }
+    for (i = 0; i <= HASHIDS_DICT_MAX_BUCKET; ++i) {
+        sizes[i + 1] += sizes[i];
+    }
+    for (i = 0; i < buckets_count; ++i) {
+        order[sizes[HASHIDS_DICT_MAX_BUCKET - (starts[i + 1] - starts[i])]++]
+            = (uint32_t)i;
+    }
+
+    memset(taken, 0, count);
+    free_slot = 0;
+    for (i = 0; i < buckets_count; ++i) {
+        bucket = order[i];
+        size = starts[bucket + 1] - starts[bucket];
+        pilots[bucket] = 0;
+        if (!size) {
+            continue;
+        }
+
+        /* a lone key takes the next free slot */
+        if (size == 1) {
+            while (taken[free_slot]) {
+                ++free_slot;
+            }
+            taken[free_slot] = 1;
+            pilots[bucket] = HASHIDS_DICT_DIRECT | (uint32_t)free_slot;
+            ids[free_slot] = keys[starts[bucket]];
+            continue;
+        }
+
+        /* the others look for a pilot sending all of them to free slots */
+        for (pilot = 0; pilot < HASHIDS_DICT_PILOTS; ++pilot) {
+            for (j = 0; j < size; ++j) {
+                slot = hashids_dict_slot(hashes[keys[starts[bucket] + j]],
+                    pilot, count);
+                if (taken[slot]) {
+                    break;
+                }
+                for (k = 0; k < j && slots[k] != slot; ++k) {
+                    /* empty */
+                }
+                if (k < j) {
+                    break;
+                }
+                slots[j] = slot;
+            }
+            if (j == size) {
+                break;
+            }
+        }
+        if (pilot == HASHIDS_DICT_PILOTS) {
+            return 0;
+        }
+
+        pilots[bucket] = pilot;
+        for (j = 0; j < size; ++j) {
+            taken[slots[j]] = 1;
+            ids[slots[j]] = keys[starts[bucket] + j];
+        }
+    }
+
+    return 1;
+}
+
+/* build the perfect hash of the strings - 0 if no seed works out, -1 if out
+   of memory */
+static int
+hashids_dict_build(struct hashids_dict_header_s *header,
+    const uint32_t *offsets, const char *strings, uint32_t *pilots,
+    uint32_t *ids)
+{
+    unsigned long long *hashes, i, count, buckets_count;
+    uint32_t *starts, *keys, *order;
+    unsigned char *taken;
+    char *scratch;
+    int result = 0;
+
+    count = header->count;
+    buckets_count = header->buckets_count;
+    scratch = (char *)_hashids_alloc(count * (sizeof(unsigned long long)
+        + sizeof(uint32_t) + 1) + (buckets_count * 2 + 1) * sizeof(uint32_t));
+    if (!scratch) {
+        return -1;
+    }
+    hashes = (unsigned long long *)scratch;
+    starts = (uint32_t *)(hashes + count);
+    order = starts + buckets_count + 1;
+    keys = order + buckets_count;
+    taken = (unsigned char *)(keys + count);
+
+    for (header->seed = 0; header->seed < HASHIDS_DICT_SEEDS; ++header->seed) {
+        for (i = 0; i < count; ++i) {
+            hashes[i] = hashids_dict_hash(0xCBF29CE484222325ull
+                ^ (header->seed * 0x9E3779B97F4A7C15ull),
+                strings + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        if (hashids_dict_place(hashes, count, buckets_count, pilots, ids,
+            starts, keys, order, taken)) {
+            result = 1;
+            break;
+        }
+    }
+
+    _hashids_free(scratch);
+    return result;
+}
+
+/* save the hashes of [0, count) to a file */
+int
+hashids_dict_save(const char *path, hashids_t *hashids,
+    unsigned long long count)
+{
+    struct hashids_dict_header_s *header;
+    hashids_range_t *range;
+    unsigned long long i, strings_size, strings, pilots, ids, size;
+    uint32_t *offsets;
+    char *image, *buffer;
+    size_t length;
+    FILE *fp;
+    int built;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (count > HASHIDS_DICT_MAX_COUNT) {
+        hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+        return HASHIDS_ERROR_INVALID_NUMBER;
+    }
+
+    /* the hashes, twice - sizing the string table, then filling it */
+    i = count ? count - 1 : 0;
+    length = hashids_estimate_encoded_size(hashids, 1, &i);
+    offsets = (uint32_t *)_hashids_alloc((count + 1) * sizeof(uint32_t)
+        + length);
+    range = hashids_range_init(hashids, 0);
+    if (!offsets || !range) {
+        _hashids_free(offsets);
+        hashids_range_free(range);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return HASHIDS_ERROR_ALLOC;
+    }
+    buffer = (char *)(offsets + count + 1);
+
+    for (i = 0, strings_size = 0; i < count; ++i) {
+        offsets[i] = (uint32_t)strings_size;
+        strings_size += hashids_range_next(range, buffer);
+        if (strings_size > 0xFFFFFFFFull) {
+            _hashids_free(offsets);
+            hashids_range_free(range);
+            hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+            return HASHIDS_ERROR_INVALID_NUMBER;
+        }
+    }
+    offsets[count] = (uint32_t)strings_size;
+    hashids_range_free(range);
+
+    /* build the image in memory, then write it out at once */
+    size = hashids_dict_layout(count, strings_size,
+        count / HASHIDS_DICT_BUCKET_KEYS + 1, &strings, &pilots, &ids);
+    image = (char *)_hashids_alloc(size);
+    range = hashids_range_init(hashids, 0);
+    if (!image || !range) {
+        _hashids_free(image);
+        _hashids_free(offsets);
+        hashids_range_free(range);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return HASHIDS_ERROR_ALLOC;
+    }
+
+    header = (struct hashids_dict_header_s *)image;
+    memcpy(header->magic, HASHIDS_DICT_MAGIC, sizeof(HASHIDS_DICT_MAGIC));
+    header->version = HASHIDS_DICT_VERSION;
+    header->byte_order = HASHIDS_DICT_BYTE_ORDER;
+    header->count = count;
+    header->size = size;
+    header->buckets_count = count / HASHIDS_DICT_BUCKET_KEYS + 1;
+    header->strings_size = strings_size;
+
+    memcpy(image + sizeof(*header), offsets, (count + 1) * sizeof(uint32_t));
+    for (i = 0; i < count; ++i) {
+        hashids_range_next(range, buffer);
+        memcpy(image + strings + offsets[i], buffer,
+            offsets[i + 1] - offsets[i]);
+    }
+    hashids_range_free(range);
+    _hashids_free(offsets);
+
+    built = hashids_dict_build(header,
+        (const uint32_t *)(image + sizeof(*header)), image + strings,
+        (uint32_t *)(image + pilots), (uint32_t *)(image + ids));
+    if (built <= 0) {
+        _hashids_free(image);
+        hashids_errno = built
+            ? HASHIDS_ERROR_ALLOC : HASHIDS_ERROR_INVALID_FILE;
+        return hashids_errno;
+    }
+
+    header->checksum = hashids_dict_hash(0xCBF29CE484222325ull,
+        image + sizeof(*header), size - sizeof(*header));
+
+    /* write */
+    fp = fopen(path, "wb");
+    if (!fp) {
+        _hashids_free(image);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+    if (fwrite(image, 1, size, fp) != size) {
+        fclose(fp);
+        _hashids_free(image);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+    _hashids_free(image);
+    if (fclose(fp) != 0) {
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+
+    return HASHIDS_ERROR_OK;
+}
+
+/* check the sections of a mapped dictionary */
+static int
+hashids_dict_ok(const hashids_dict_t *dict,
+    const struct hashids_dict_header_s *header)
+{
+    unsigned long long i;
+
+    if (dict->offsets[0] != 0
+        || dict->offsets[dict->count] != header->strings_size) {
+        return 0;
+    }
+    for (i = 0; i < dict->count; ++i) {
+        if (dict->offsets[i] > dict->offsets[i + 1]
+            || dict->ids[i] >= dict->count) {
+            return 0;
+        }
+    }
+    for (i = 0; i < dict->buckets_count; ++i) {
+        if ((dict->pilots[i] & HASHIDS_DICT_DIRECT)
+            && (dict->pilots[i] & ~HASHIDS_DICT_DIRECT) >= dict->count) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* "destructor" */
+void
+hashids_dict_close(hashids_dict_t *dict)
+{
+    if (dict) {
+        if (dict->map) {
+            munmap(dict->map, dict->map_size);
+        }
+
+        _hashids_free(dict);
+    }
+}
+
+/* map a dictionary */
+hashids_dict_t *
+hashids_dict_open(const char *path)
+{
+    hashids_dict_t *result;
+    const struct hashids_dict_header_s *header;
+    unsigned long long strings, pilots, ids;
+    struct stat st;
+    const char *image;
+    int fd;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    result = (hashids_dict_t *)_hashids_alloc(sizeof(hashids_dict_t));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    /* map the whole thing read-only, shared through the page cache */
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(*header)) {
+        close(fd);
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+        return NULL;
+    }
+    result->map_size = (size_t)st.st_size;
+    result->map = mmap(NULL, result->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (result->map == MAP_FAILED) {
+        result->map = NULL;
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    image = (const char *)result->map;
+
+    /* validate the header, the layout & the checksum */
+    header = (const struct hashids_dict_header_s *)image;
+    if (memcmp(header->magic, HASHIDS_DICT_MAGIC, sizeof(HASHIDS_DICT_MAGIC))
+        || header->version != HASHIDS_DICT_VERSION
+        || header->byte_order != HASHIDS_DICT_BYTE_ORDER
+        || header->size != result->map_size
+        || header->count > HASHIDS_DICT_MAX_COUNT
+        || header->strings_size > 0xFFFFFFFFull
+        || header->buckets_count != header->count / HASHIDS_DICT_BUCKET_KEYS
+            + 1
+        || hashids_dict_layout(header->count, header->strings_size,
+            header->buckets_count, &strings, &pilots, &ids) != header->size
+        || header->checksum != hashids_dict_hash(0xCBF29CE484222325ull,
+            image + sizeof(*header), header->size - sizeof(*header))) {
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+        return NULL;
+    }
+
+    result->count = header->count;
+    result->seed = header->seed;
+    result->buckets_count = header->buckets_count;
+    result->offsets = (const uint32_t *)(image + sizeof(*header));
+    result->strings = image + strings;
+    result->pilots = (const uint32_t *)(image + pilots);
+    result->ids = (const uint32_t *)(image + ids);
+
+    if (!hashids_dict_ok(result, header)) {
+        hashids_dict_close(result);
+        hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+        return NULL;
+    }
+
+    return result;
+}
+
+/* numbers in a dictionary */
+unsigned long long
+hashids_dict_count(const hashids_dict_t *dict)
+{
+    return dict->count;
+}
+
+/* hashids_encode_one() of a number below the count */
+size_t
+hashids_dict_encode(const hashids_dict_t *dict, char *buffer,
+    unsigned long long number)
+{
+    size_t length;
+
+    if (number >= dict->count) {
+        hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+        return 0;
+    }
+
+    length = dict->offsets[number + 1] - dict->offsets[number];
+    memcpy(buffer, dict->strings + dict->offsets[number], length);
+    buffer[length] = '\0';
+
+    return length;
+}
+
+/* the number of a hash, if hashids_encode_one() gives exactly that hash */
+size_t
+hashids_dict_decode(const hashids_dict_t *dict, const char *str,
+    unsigned long long *number)
+{
+    unsigned long long hash, slot;
+    uint32_t candidate;
+    size_t length;
+
+    length = strlen(str);
+    hash = hashids_dict_hash(0xCBF29CE484222325ull
+        ^ (dict->seed * 0x9E3779B97F4A7C15ull), str, length);
+
+    if (dict->count) {
+        slot = hashids_dict_slot(hash, dict->pilots[hashids_dict_bucket(hash,
+            dict->buckets_count)], dict->count);
+        candidate = dict->ids[slot];
+        if (dict->offsets[candidate + 1] - dict->offsets[candidate] == length
+            && memcmp(dict->strings + dict->offsets[candidate], str,
+                length) == 0) {
+            *number = candidate;
+            return 1;
+        }
+    }
+
+    hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+    return 0;
+}
@@ -0,0 +1,526 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hashids.h"
+
+/* file format constants */
+#define HASHIDS_FILE_MAGIC "HASHIDS"
+#define HASHIDS_FILE_VERSION 3u
+#define HASHIDS_FILE_BYTE_ORDER 0x01020304u
+#define HASHIDS_FILE_ALIGNMENT 8u
+
+/*
+ * File layout (native byte order, all offsets relative to the file start):
+ *
+ *   header | record * count | storage & prepared blocks (8-byte aligned)
+ *
+ * String offsets inside a record are relative to its storage block, so the
+ * whole file is position-independent and can be mapped anywhere.
+ */
+struct hashids_file_header_s {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned long long count;
+    unsigned long long size;
+    unsigned long long checksum;
+};
+
+struct hashids_file_record_s {
+    unsigned long long min_hash_length;
+
+    unsigned long long storage_offset;
+    unsigned long long storage_size;
+    unsigned long long prepared_offset;
+    unsigned long long prepared_size;
+
+    unsigned long long salt;
+    unsigned long long salt_length;
+    unsigned long long alphabet;
+    unsigned long long alphabet_length;
+    unsigned long long separators;
+    unsigned long long separators_count;
+    unsigned long long guards;
+    unsigned long long guards_count;
+    unsigned long long shuffle_steps;
+    unsigned long long shuffle_steps_count;
+    unsigned long long shuffle_sum;
+    unsigned long long pad_templates;
+    unsigned long long pad_digits_count;
+
+    unsigned long long prepared_alphabet_length;
+    unsigned long long prepared_separators_count;
+};
+
+/* the file "object" */
+struct hashids_file_s {
+    void *map;
+    size_t map_size;
+    size_t count;
+    hashids_t *instances;
+};
+
+/* round up to the file alignment */
+static inline unsigned long long
+hashids_file_align(unsigned long long offset)
+{
+    return (offset + HASHIDS_FILE_ALIGNMENT - 1)
+        & ~(unsigned long long)(HASHIDS_FILE_ALIGNMENT - 1);
+}
+
+/* checksum - a word-at-a-time multiplicative hash */
+static unsigned long long
+hashids_file_checksum(const char *data, size_t length)
+{
+    unsigned long long hash = 0xCBF29CE484222325ull, word;
+
+    for (; length >= sizeof(word); length -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        data += sizeof(word);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+
+    word = 0;
+    memcpy(&word, data, length);
+    hash = (hash ^ word ^ ((unsigned long long)length << 56))
+        * 0x9E3779B97F4A7C15ull;
+
+    return hash ^ (hash >> 29);
+}
+
+/* save instances to a file */
+int
+hashids_file_save(const char *path, hashids_t **instances, size_t count)
+{
+    struct hashids_file_header_s *header;
+    struct hashids_file_record_s *record;
+    unsigned long long offset;
+    hashids_t *hashids;
+    char *image;
+    size_t i;
+    FILE *fp;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* lay out the blocks */
+    offset = sizeof(*header) + count * sizeof(*record);
+    for (i = 0; i < count; ++i) {
+        hashids = instances[i];
+        offset = hashids_file_align(offset) + hashids->storage_size;
+        offset = hashids_file_align(offset)
+            + hashids->prepared_alphabet_length
+            + hashids->prepared_separators_count + 1;
+    }
+
+    /* build the image in memory, then write it out at once */
+    image = (char *)_hashids_alloc(offset);
+    if (!image) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return HASHIDS_ERROR_ALLOC;
+    }
+
+    header = (struct hashids_file_header_s *)image;
+    memcpy(header->magic, HASHIDS_FILE_MAGIC, sizeof(HASHIDS_FILE_MAGIC));
+    header->version = HASHIDS_FILE_VERSION;
+    header->byte_order = HASHIDS_FILE_BYTE_ORDER;
+    header->count = count;
+    header->size = offset;
+
+    offset = sizeof(*header) + count * sizeof(*record);
+    for (i = 0; i < count; ++i) {
+        hashids = instances[i];
+        record = (struct hashids_file_record_s *)(image + sizeof(*header))
+            + i;
+
+        record->min_hash_length = hashids->min_hash_length;
+
+        offset = hashids_file_align(offset);
+        record->storage_offset = offset;
+        record->storage_size = hashids->storage_size;
+        memcpy(image + offset, hashids->storage, hashids->storage_size);
+        offset += hashids->storage_size;
+
+        offset = hashids_file_align(offset);
+        record->prepared_offset = offset;
+        record->prepared_size = hashids->prepared_alphabet_length
+            + hashids->prepared_separators_count + 1;
+        memcpy(image + offset, hashids->prepared, record->prepared_size);
+        offset += record->prepared_size;
+
+        record->salt = hashids->salt - hashids->storage;
+        record->salt_length = hashids->salt_length;
+        record->alphabet = hashids->alphabet - hashids->storage;
+        record->alphabet_length = hashids->alphabet_length;
+        record->separators = hashids->separators - hashids->storage;
+        record->separators_count = hashids->separators_count;
+        record->guards = hashids->guards - hashids->storage;
+        record->guards_count = hashids->guards_count;
+        record->shuffle_steps = hashids->shuffle_steps
+            ? (char *)hashids->shuffle_steps - hashids->storage : 0;
+        record->shuffle_steps_count = hashids->shuffle_steps_count;
+        record->shuffle_sum = hashids->shuffle_sum;
+        record->pad_templates = hashids->pad_templates
+            ? (char *)hashids->pad_templates - hashids->storage : 0;
+        record->pad_digits_count = hashids->pad_digits_count;
+        record->prepared_alphabet_length = hashids->prepared_alphabet_length;
+        record->prepared_separators_count =
+            hashids->prepared_separators_count;
+    }
+
+    header->checksum = hashids_file_checksum(image + sizeof(*header),
+        header->size - sizeof(*header));
+
+    /* write */
+    fp = fopen(path, "wb");
+    if (!fp) {
+        _hashids_free(image);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+    if (fwrite(image, 1, header->size, fp) != header->size) {
+        fclose(fp);
+        _hashids_free(image);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+    _hashids_free(image);
+    if (fclose(fp) != 0) {
+        hashids_errno = HASHIDS_ERROR_IO;
+        return HASHIDS_ERROR_IO;
+    }
+
+    return HASHIDS_ERROR_OK;
+}
+
+/* check that [offset, offset + length] holds a NUL-terminated string */
+static inline int
+hashids_file_string_ok(const char *block, unsigned long long block_size,
+    unsigned long long offset, unsigned long long length)
+{
+    return offset < block_size && length < block_size - offset
+        && block[offset + length] == '\0'
+        && !memchr(block + offset, '\0', length);
+}
+
+/* check that the alphabet, separators & guards are what setup makes - at
+   least 2 + 1 + 1 characters, no more than an alphabet can hold, and no
+   character in two places */
+static inline int
+hashids_file_sets_ok(const char *storage,
+    const struct hashids_file_record_s *record)
+{
+    unsigned char seen[256];
+    const unsigned char *p, *end;
+
+    if (record->alphabet_length < 2
+        || record->alphabet_length + record->separators_count
+            + record->guards_count > HASHIDS_MAX_ALPHABET_LENGTH) {
+        return 0;
+    }
+
+    memset(seen, 0, sizeof(seen));
+    for (p = (const unsigned char *)storage + record->alphabet,
+        end = p + record->alphabet_length; p < end; ++p) {
+        if (seen[*p]++) {
+            return 0;
+        }
+    }
+    for (p = (const unsigned char *)storage + record->separators,
+        end = p + record->separators_count; p < end; ++p) {
+        if (seen[*p]++) {
+            return 0;
+        }
+    }
+    for (p = (const unsigned char *)storage + record->guards,
+        end = p + record->guards_count; p < end; ++p) {
+        if (seen[*p]++) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* check the precomputed shuffle steps of a record */
+static inline int
+hashids_file_steps_ok(const char *storage,
+    const struct hashids_file_record_s *record)
+{
+    const unsigned char *steps;
+    unsigned long long i, k;
+
+    if (record->shuffle_steps_count >= record->alphabet_length
+        || record->shuffle_steps > record->storage_size
+        || record->alphabet_length * record->shuffle_steps_count
+            > record->storage_size - record->shuffle_steps) {
+        return 0;
+    }
+
+    steps = (const unsigned char *)storage + record->shuffle_steps;
+    for (i = 0; i < record->alphabet_length; ++i) {
+        for (k = 0; k < record->shuffle_steps_count; ++k) {
+            if (*steps++ >= record->alphabet_length - 1 - k) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/* check the padding templates of a record - the left pads must fit */
+static inline int
+hashids_file_pads_ok(const char *storage,
+    const struct hashids_file_record_s *record)
+{
+    const unsigned char *row;
+    unsigned long long i, k, n, size;
+
+    n = record->pad_digits_count;
+    if (!n) {
+        return 1;
+    }
+
+    size = n * (n + 3) / 2;
+    if (n + 4 != record->min_hash_length
+        || record->pad_templates > record->storage_size
+        || record->alphabet_length * size
+            > record->storage_size - record->pad_templates) {
+        return 0;
+    }
+
+    row = (const unsigned char *)storage + record->pad_templates;
+    for (i = 0; i < record->alphabet_length; ++i) {
+        for (k = 1; k <= n; ++k) {
+            if (*row > n + 1 - k || memchr(row + 1, '\0', n + 1 - k)) {
+                return 0;
+            }
+            row += n + 2 - k;
+        }
+    }
+
+    return 1;
+}
+
+/* validate a record against the mapped image */
+static int
+hashids_file_record_ok(const char *image, unsigned long long size,
+    unsigned long long data_offset, const struct hashids_file_record_s *record)
+{
+    const char *storage, *prepared;
+
+    /* blocks must be inside the data area */
+    if (record->storage_offset < data_offset
+        || record->storage_offset > size
+        || record->storage_size > size - record->storage_offset
+        || record->prepared_offset < data_offset
+        || record->prepared_offset > size
+        || record->prepared_size > size - record->prepared_offset) {
+        return 0;
+    }
+    storage = image + record->storage_offset;
+    prepared = image + record->prepared_offset;
+
+    /* strings must be inside the storage block and sane */
+    if (!record->alphabet_length
+        || record->alphabet_length > HASHIDS_MAX_ALPHABET_LENGTH
+        || !record->separators_count || !record->guards_count
+        || !hashids_file_string_ok(storage, record->storage_size,
+            record->salt, record->salt_length)
+        || !hashids_file_string_ok(storage, record->storage_size,
+            record->alphabet, record->alphabet_length)
+        || !hashids_file_string_ok(storage, record->storage_size,
+            record->separators, record->separators_count)
+        || !hashids_file_string_ok(storage, record->storage_size,
+            record->guards, record->guards_count)) {
+        return 0;
+    }
+
+    /* the character sets must not overlap */
+    if (!hashids_file_sets_ok(storage, record)) {
+        return 0;
+    }
+
+        /* shuffle steps must stay inside the alphabet they swap */
+    if (!hashids_file_steps_ok(storage, record)) {
+        return 0;
+    }
+
+    /* padding templates must add up to min_hash_length */
+    if (!hashids_file_pads_ok(storage, record)) {
+        return 0;
+    }
+
+    /* the prepared alphabet must add up */
+    if (record->prepared_alphabet_length > record->prepared_size
+        || record->prepared_separators_count > record->prepared_size
+        || !hashids_file_string_ok(prepared, record->prepared_size, 0,
+            record->prepared_alphabet_length
+            + record->prepared_separators_count)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/* "destructor" */
+void
+hashids_file_close(hashids_file_t *file)
+{
+    if (file) {
+        if (file->map) {
+            munmap(file->map, file->map_size);
+        }
+        if (file->instances) {
+            _hashids_free(file->instances);
+        }
+
+        _hashids_free(file);
+    }
+}
+
+/* map a file of instances */
+hashids_file_t *
+hashids_file_open(const char *path)
+{
+    hashids_file_t *result;
+    const struct hashids_file_header_s *header;
+    const struct hashids_file_record_s *record;
+    unsigned long long data_offset;
+    hashids_t *hashids;
+    struct stat st;
+    const char *image;
+    size_t i;
+    int fd;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    result = (hashids_file_t *)_hashids_alloc(sizeof(hashids_file_t));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    /* map the whole thing read-only, shared through the page cache */
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(*header)) {
+        close(fd);
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+        return NULL;
+    }
+    result->map_size = (size_t)st.st_size;
+    result->map = mmap(NULL, result->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (result->map == MAP_FAILED) {
+        result->map = NULL;
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return NULL;
+    }
+    image = (const char *)result->map;
+
+    /* validate the header & checksum */
+    header = (const struct hashids_file_header_s *)image;
+    if (memcmp(header->magic, HASHIDS_FILE_MAGIC, sizeof(HASHIDS_FILE_MAGIC))
+        || header->version != HASHIDS_FILE_VERSION
+        || header->byte_order != HASHIDS_FILE_BYTE_ORDER
+        || header->size != result->map_size
+        || header->count > (header->size - sizeof(*header)) / sizeof(*record)
+        || header->checksum != hashids_file_checksum(image + sizeof(*header),
+            header->size - sizeof(*header))) {
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+        return NULL;
+    }
+    data_offset = sizeof(*header) + header->count * sizeof(*record);
+
+    /* instance handles pointing into the mapping */
+    result->count = header->count;
+    result->instances = (hashids_t *)_hashids_alloc(
+        (result->count ? result->count : 1) * sizeof(hashids_t));
+    if (!result->instances) {
+        hashids_file_close(result);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    for (i = 0; i < result->count; ++i) {
+        record = (const struct hashids_file_record_s *)(image
+            + sizeof(*header)) + i;
+        if (!hashids_file_record_ok(image, header->size, data_offset,
+            record)) {
+            hashids_file_close(result);
+            hashids_errno = HASHIDS_ERROR_INVALID_FILE;
+            return NULL;
+        }
+
+        hashids = &result->instances[i];
+        hashids->storage = (char *)image + record->storage_offset;
+        hashids->storage_size = record->storage_size;
+        hashids->salt = hashids->storage + record->salt;
+        hashids->salt_length = record->salt_length;
+        hashids->alphabet = hashids->storage + record->alphabet;
+        hashids->alphabet_length = record->alphabet_length;
+        hashids->separators = hashids->storage + record->separators;
+        hashids->separators_count = record->separators_count;
+        hashids->guards = hashids->storage + record->guards;
+        hashids->guards_count = record->guards_count;
+        hashids->shuffle_steps = record->shuffle_steps_count
+            ? (unsigned char *)hashids->storage + record->shuffle_steps : NULL;
+        hashids->shuffle_steps_count = record->shuffle_steps_count;
+        hashids->shuffle_sum = record->shuffle_sum;
+        hashids->pad_templates = record->pad_digits_count
+            ? (unsigned char *)hashids->storage + record->pad_templates : NULL;
+        hashids->pad_digits_count = record->pad_digits_count;
+        hashids->tables = (hashids->shuffle_steps ? HASHIDS_TABLE_SHUFFLE : 0)
+            | (hashids->pad_templates ? HASHIDS_TABLE_PAD : 0);
+        hashids->min_hash_length = record->min_hash_length;
+        hashids->prepared = (char *)image + record->prepared_offset;
+        hashids->prepared_alphabet_length = record->prepared_alphabet_length;
+        hashids->prepared_separators_count =
+            record->prepared_separators_count;
+        hashids->allocator = hashids_default_allocator;
+    }
+
+    return result;
+}
+
+/* number of instances in a file */
+size_t
+hashids_file_count(const hashids_file_t *file)
+{
+    return file->count;
+}
+
+/* a mapped instance - owned by the file, do not hashids_free() it */
+hashids_t *
+hashids_file_get(hashids_file_t *file, size_t index)
+{
+    if (index >= file->count) {
+        return NULL;
+    }
+
+    return &file->instances[index];
+}
@@ -1,7 +1,12 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <math.h>
 
 #include "hashids.h"
@@ -18,6 +23,24 @@
 #   define HASHIDS_UNLIKELY(x)      (x)
 #endif
 
+/* SSE2 hex conversion */
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#   define HASHIDS_HAVE_SSE2 1
+#endif
+
+/* 128-bit multiplication */
+#if defined(__SIZEOF_INT128__)
+#   define HASHIDS_HAVE_INT128 1
+#endif
+
+/* AVX2 batch kernels, picked at run time */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && __has_builtin(__builtin_cpu_supports)
+#   include <immintrin.h>
+#   define HASHIDS_HAVE_AVX2 1
+#endif
+
 /* fallthrough warning suppression */
 #ifndef __has_feature
 #   define __has_feature(x) (0)
@@ -41,6 +64,21 @@ __hashids_errno_addr()
     return &__hashids_errno_val;
 }
 
+/* variadic arguments gathered on the stack before falling back to alloc() */
+#define HASHIDS_VA_STACK_NUMBERS 32
+
+/* big numbers up to this many 32-bit limbs stay on the stack (512 bits) */
+#define HASHIDS_BIG_STACK_LIMBS 16
+
+/* re-encodes of big numbers this long stay on the stack when decoding */
+#define HASHIDS_BIG_STACK_HASH 256
+
+/* digit values of a 64-bit number in a batch, leading zeros included */
+#define HASHIDS_BATCH_MAX_DIGITS 96
+
+/* numbers per batch kernel iteration */
+#define HASHIDS_BATCH_LANES 8
+
 /* default alloc() implementation */
 static inline void *
 hashids_alloc_f(size_t size)
@@ -58,6 +96,107 @@ hashids_free_f(void *ptr)
 void *(*_hashids_alloc)(size_t size) = hashids_alloc_f;
 void (*_hashids_free)(void *ptr) = hashids_free_f;
 
+/* default allocator context - defers to the global function pointers */
+static void *
+hashids_default_alloc_f(void *ctx, size_t size)
+{
+    (void)ctx;
+    return _hashids_alloc(size);
+}
+
+static void
+hashids_default_free_f(void *ctx, void *ptr)
+{
+    (void)ctx;
+    _hashids_free(ptr);
+}
+
+const hashids_allocator_t hashids_default_allocator = {
+    hashids_default_alloc_f, hashids_default_free_f, NULL
+};
+
+/* per-instance alloc() */
+static inline void *
+hashids_instance_alloc(hashids_t *hashids, size_t size)
+{
+    return hashids->allocator.alloc(hashids->allocator.ctx, size);
+}
+
+/* per-instance free() */
+static inline void
+hashids_instance_free(hashids_t *hashids, void *ptr)
+{
+    hashids->allocator.free(hashids->allocator.ctx, ptr);
+}
+
+/* arena alignment (enough for any scalar type we hand out) */
+#define HASHIDS_ARENA_ALIGNMENT (2 * sizeof(void *))
+
+/* round an arena offset up to the alignment */
+static inline size_t
+hashids_arena_align(size_t offset)
+{
+    return (offset + HASHIDS_ARENA_ALIGNMENT - 1)
+        & ~(HASHIDS_ARENA_ALIGNMENT - 1);
+}
+
+/* arena alloc() - bump the offset, hand out zeroed memory */
+static void *
+hashids_arena_alloc_f(void *ctx, size_t size)
+{
+    hashids_arena_t *arena = (hashids_arena_t *)ctx;
+    size_t offset;
+
+    offset = hashids_arena_align(arena->used);
+    if (HASHIDS_UNLIKELY(offset > arena->size
+        || size > arena->size - offset)) {
+        return NULL;
+    }
+
+    arena->last = arena->used;
+    arena->used = offset + size;
+
+    return memset(arena->buffer + offset, 0, size);
+}
+
+/* arena free() - only the most recent allocation can be given back */
+static void
+hashids_arena_free_f(void *ctx, void *ptr)
+{
+    hashids_arena_t *arena = (hashids_arena_t *)ctx;
+
+    if ((char *)ptr == arena->buffer + hashids_arena_align(arena->last)) {
+        arena->used = arena->last;
+    }
+}
+
+/* initialize an arena over a caller-provided buffer */
+void
+hashids_arena_init(hashids_arena_t *arena, void *buffer, size_t size)
+{
+    arena->allocator.alloc = hashids_arena_alloc_f;
+    arena->allocator.free = hashids_arena_free_f;
+    arena->allocator.ctx = arena;
+    arena->buffer = (char *)buffer;
+    arena->size = size;
+    arena->used = 0;
+    arena->last = 0;
+}
+
+/* release everything allocated from the arena */
+void
+hashids_arena_reset(hashids_arena_t *arena)
+{
+    arena->used = 0;
+    arena->last = 0;
+}
+
+/* 256-bit character presence sets */
+#define HASHIDS_CHARSET_ADD(set, ch) \
+    ((set)[(unsigned char)(ch) >> 3] |= 1u << ((unsigned char)(ch) & 7))
+#define HASHIDS_CHARSET_HAS(set, ch) \
+    ((set)[(unsigned char)(ch) >> 3] & (1u << ((unsigned char)(ch) & 7)))
+
 /* fast ceil(x / y) for size_t arguments */
 static inline size_t
 hashids_div_ceil_size_t(size_t x, size_t y)
@@ -98,11 +237,22 @@ hashids_log2_64(unsigned long long x)
         ((unsigned long long)((x - (x >> 1)) * 0x07EDD5E59A4E28C2)) >> 58];
 }
 
+/* x % y - a 32-bit division is a lot cheaper and nearly always enough */
+static inline size_t
+hashids_mod(size_t x, size_t y)
+{
+    if (HASHIDS_LIKELY(x <= 0xFFFFFFFFu)) {
+        return (uint32_t)x % (uint32_t)y;
+    }
+
+    return x % y;
+}
+
 /* shuffle loop step */
 #define hashids_shuffle_step(iter) \
     if (i == 0) { break; }                                      \
     if (v == salt_length) { v = 0; }                            \
-    p += salt[v]; j = (salt[v] + v + p) % (iter);               \
+    p += salt[v]; j = hashids_mod(salt[v] + v + p, (iter));     \
     temp = str[(iter)]; str[(iter)] = str[j]; str[j] = temp;    \
     --i; ++v;
 
@@ -188,124 +338,452 @@ hashids_shuffle(char *str, size_t str_length, char *salt, size_t salt_length)
     }
 }
 
-/* "destructor" */
-void
-hashids_free(hashids_t *hashids)
+/*
+ * The per-number shuffle of a lottery - the salt is lottery + salt + the
+ * alphabet as it was, so the first steps only depend on the lottery and are
+ * precomputed by hashids_setup() with HASHIDS_TABLE_SHUFFLE. The tail needs
+ * alphabet_length - 1 - shuffle_steps_count bytes of scratch space.
+ */
+static inline void
+hashids_shuffle_lottery(hashids_t *hashids, char *alphabet, size_t lottery,
+    char *tail_salt)
 {
-    if (hashids) {
-        if (hashids->alphabet) {
-            _hashids_free(hashids->alphabet);
+    const unsigned char *steps;
+    size_t i, j, v, p, steps_count;
+    char temp;
+
+    /* no table - the whole salt, the last character of it is never used */
+    if (!hashids->shuffle_steps) {
+        i = hashids->alphabet_length - 1;
+        j = hashids->salt_length < i - 1 ? hashids->salt_length : i - 1;
+        tail_salt[0] = hashids->alphabet[lottery];
+        memcpy(tail_salt + 1, hashids->salt, j);
+        memcpy(tail_salt + 1 + j, alphabet, i - 1 - j);
+        hashids_shuffle(alphabet, hashids->alphabet_length, tail_salt, i);
+        return;
+    }
+
+    steps_count = hashids->shuffle_steps_count;
+    steps = hashids->shuffle_steps + lottery * steps_count;
+    i = hashids->alphabet_length - 1;
+
+    /* the tail is salted by the alphabet before any swaps */
+    if (i > steps_count) {
+        memcpy(tail_salt, alphabet, i - steps_count);
+    }
+
+    /* the precomputed steps */
+    for (v = 0; v < steps_count; ++v, --i) {
+        j = steps[v];
+        temp = alphabet[i]; alphabet[i] = alphabet[j]; alphabet[j] = temp;
+    }
+
+    /* the tail */
+    p = hashids->shuffle_sum + hashids->alphabet[lottery];
+    for (v = 0; i > 0; ++v, --i) {
+        p += tail_salt[v];
+        j = hashids_mod(tail_salt[v] + steps_count + v + p, i);
+        temp = alphabet[i]; alphabet[i] = alphabet[j]; alphabet[j] = temp;
+    }
+}
+
+/* one round of padding from a freshly shuffled alphabet */
+static inline size_t
+hashids_pad_step(hashids_t *hashids, char *buffer, size_t result_len,
+    const char *alphabet)
+{
+    size_t i, j, half_length_ceil, half_length_floor;
+
+    /* pad with half alphabet before and after */
+    half_length_ceil = hashids_div_ceil_size_t(hashids->alphabet_length, 2);
+    half_length_floor = floor((float)hashids->alphabet_length / 2);
+
+    /* left pad from the end of the alphabet */
+    i = hashids_div_ceil_size_t(hashids->min_hash_length - result_len, 2);
+    /* right pad from the beginning */
+    j = floor((float)(hashids->min_hash_length - result_len) / 2);
+
+    /* check bounds */
+    if (i > half_length_ceil) {
+        i = half_length_ceil;
+    }
+    if (j > half_length_floor) {
+        j = half_length_floor;
+    }
+
+    /* handle excessively excessive excess */
+    if ((i + j) % 2 == 0 && hashids->alphabet_length % 2 == 1) {
+        ++i; --j;
+    }
+
+    /* move the current result to "center" */
+    memmove(buffer + i, buffer, result_len);
+    /* pad left */
+    memmove(buffer, alphabet + hashids->alphabet_length - i, i);
+    /* pad right */
+    memmove(buffer + i + result_len, alphabet, j);
+
+    return result_len + i + j;
+}
+
+/* add guards and alphabet padding up to min_hash_length */
+static size_t
+hashids_encode_pad(hashids_t *hashids, char *buffer, size_t result_len,
+    unsigned long long numbers_hash, char *alphabet_copy_1,
+    char *alphabet_copy_2)
+{
+    size_t guard_index;
+
+    if (result_len < hashids->min_hash_length) {
+        /* add a guard before the encoded numbers */
+        guard_index = (numbers_hash + buffer[0]) % hashids->guards_count;
+        memmove(buffer + 1, buffer, result_len);
+        buffer[0] = hashids->guards[guard_index];
+        ++result_len;
+
+        if (result_len < hashids->min_hash_length) {
+            /* add a guard after the encoded numbers */
+            guard_index = (numbers_hash + buffer[2]) % hashids->guards_count;
+            buffer[result_len] = hashids->guards[guard_index];
+            ++result_len;
+
+            /* pad, pad, pad */
+            while (result_len < hashids->min_hash_length) {
+                /* shuffle the alphabet */
+                strncpy(alphabet_copy_2, alphabet_copy_1,
+                    hashids->alphabet_length);
+                hashids_shuffle(alphabet_copy_1,
+                    hashids->alphabet_length, alphabet_copy_2,
+                    hashids->alphabet_length);
+
+                result_len = hashids_pad_step(hashids, buffer, result_len,
+                    alphabet_copy_1);
+            }
         }
-        if (hashids->alphabet_copy_1) {
-            _hashids_free(hashids->alphabet_copy_1);
+    }
+
+    return result_len;
+}
+
+/* padding templates cover single numbers up to this min_hash_length */
+#define HASHIDS_PAD_TEMPLATE_MAX 32u
+
+/*
+ * Padding templates - for a single number, the alphabet entering the padding
+ * loop only depends on the lottery, so the pad characters only depend on the
+ * lottery & the digits count. A row per digits count that gets padded (1 to
+ * pad_digits_count), each the left pad length & the pad characters left to
+ * right, a block of rows per lottery.
+ */
+static inline size_t
+hashids_pad_templates_size(size_t digits_count)
+{
+    return digits_count * (digits_count + 3) / 2;
+}
+
+/* the template of a lottery & digits count */
+static inline const unsigned char *
+hashids_pad_template(hashids_t *hashids, size_t lottery, size_t digits_count)
+{
+    size_t n = hashids->pad_digits_count;
+
+    return hashids->pad_templates + lottery * hashids_pad_templates_size(n)
+        + (digits_count - 1) * (n + 2) - (digits_count - 1) * digits_count / 2;
+}
+
+/* pad a single-number hash - a template copy when there is one */
+static inline size_t
+hashids_encode_pad_one(hashids_t *hashids, char *buffer, size_t result_len,
+    unsigned long long numbers_hash, size_t lottery, char *alphabet_copy_1,
+    char *alphabet_copy_2)
+{
+    const unsigned char *row;
+    size_t left, right;
+    char lottery_ch, first_ch;
+
+    /* templates cover everything that gets both guards & some padding */
+    if (!hashids->pad_templates
+        || result_len + 2 >= hashids->min_hash_length) {
+        return hashids_encode_pad(hashids, buffer, result_len, numbers_hash,
+            alphabet_copy_1, alphabet_copy_2);
+    }
+
+    row = hashids_pad_template(hashids, lottery, result_len - 1);
+    left = row[0];
+    right = hashids->min_hash_length - result_len - 2 - left;
+    lottery_ch = buffer[0];
+    first_ch = buffer[1];
+
+    /* left pad, guard, hash, guard, right pad */
+    memmove(buffer + left + 1, buffer, result_len);
+    memcpy(buffer, row + 1, left);
+    buffer[left] = hashids->guards[(numbers_hash + lottery_ch)
+        % hashids->guards_count];
+    buffer[left + 1 + result_len] = hashids->guards[(numbers_hash + first_ch)
+        % hashids->guards_count];
+    memcpy(buffer + left + 2 + result_len, row + 1 + left, right);
+
+    return hashids->min_hash_length;
+}
+
+/*
+ * Build the padding templates. Every round of padding shuffles the alphabet
+ * the same way whatever the digits count, so a lottery pads all of its
+ * digits counts at once, one shuffle a round. The hashes are left as NULs.
+ */
+static void
+hashids_pad_setup(hashids_t *result)
+{
+    unsigned char *row;
+    size_t lottery, digits_count, left, right, padding;
+    size_t lengths[HASHIDS_PAD_TEMPLATE_MAX];
+    char buffers[HASHIDS_PAD_TEMPLATE_MAX][HASHIDS_PAD_TEMPLATE_MAX + 1];
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    row = result->pad_templates;
+    for (lottery = 0; lottery < result->alphabet_length; ++lottery) {
+        memcpy(alphabet_copy_1, result->alphabet, result->alphabet_length);
+        alphabet_copy_1[result->alphabet_length] = '\0';
+        hashids_shuffle_lottery(result, alphabet_copy_1, lottery,
+            alphabet_copy_2);
+
+        /* guards, lottery & digits */
+        for (digits_count = 1; digits_count <= result->pad_digits_count;
+            ++digits_count) {
+            lengths[digits_count] = digits_count + 3;
+            memset(buffers[digits_count], 0, digits_count + 3);
         }
-        if (hashids->alphabet_copy_2) {
-            _hashids_free(hashids->alphabet_copy_2);
+
+        /* the fewest digits need the most rounds */
+        while (lengths[1] < result->min_hash_length) {
+            strncpy(alphabet_copy_2, alphabet_copy_1,
+                result->alphabet_length);
+            hashids_shuffle(alphabet_copy_1, result->alphabet_length,
+                alphabet_copy_2, result->alphabet_length);
+
+            for (digits_count = 1; digits_count <= result->pad_digits_count;
+                ++digits_count) {
+                if (lengths[digits_count] < result->min_hash_length) {
+                    lengths[digits_count] = hashids_pad_step(result,
+                        buffers[digits_count], lengths[digits_count],
+                        alphabet_copy_1);
+                }
+            }
         }
-        if (hashids->salt) {
-            _hashids_free(hashids->salt);
+
+        /* pads are never NUL - the first NUL is the first guard */
+        for (digits_count = 1; digits_count <= result->pad_digits_count;
+            ++digits_count) {
+            padding = result->min_hash_length - digits_count - 3;
+            left = (char *)memchr(buffers[digits_count], '\0',
+                result->min_hash_length) - buffers[digits_count];
+            right = padding - left;
+
+            *row++ = (unsigned char)left;
+            memcpy(row, buffers[digits_count], left);
+            memcpy(row + left, buffers[digits_count] + left + digits_count + 3,
+                right);
+            row += padding;
         }
-        if (hashids->separators) {
-            _hashids_free(hashids->separators);
+    }
+}
+
+/* "destructor" */
+void
+hashids_free(hashids_t *hashids)
+{
+    hashids_allocator_t allocator;
+
+    if (hashids) {
+        allocator = hashids->allocator;
+
+        if (hashids->storage) {
+            allocator.free(allocator.ctx, hashids->storage);
         }
-        if (hashids->guards) {
-            _hashids_free(hashids->guards);
+        if (hashids->prepared) {
+            allocator.free(allocator.ctx, hashids->prepared);
         }
 
-        _hashids_free(hashids);
+        allocator.free(allocator.ctx, hashids);
     }
 }
 
-/* common init */
-hashids_t *
-hashids_init3(const char *salt, size_t min_hash_length, const char *alphabet)
+/* salt-independent preparation: deduplicate, validate, split separators */
+static int
+hashids_prepare(hashids_t *result, const char *alphabet)
 {
-    hashids_t *result;
     size_t i, j, len;
-    char ch, *p;
-
-    hashids_errno = HASHIDS_ERROR_OK;
-
-    /* allocate the structure */
-    result = (hashids_t *)_hashids_alloc(sizeof(hashids_t));
-    if (HASHIDS_UNLIKELY(!result)) {
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return NULL;
-    }
+    unsigned char seen[32], separators[32];
+    char ch;
 
     /* allocate enough space for the alphabet */
     len = strlen(alphabet) + 1;
-    result->alphabet = (char *)_hashids_alloc(len);
+    result->prepared = (char *)hashids_instance_alloc(result, len);
+    if (HASHIDS_UNLIKELY(!result->prepared)) {
+        return HASHIDS_ERROR_ALLOC;
+    }
 
     /* extract only the unique characters */
-    result->alphabet[0] = '\0';
-    for (i = 0, j = 0; i < len; ++i) {
-        ch = alphabet[i];
-        if (!strchr(result->alphabet, ch)) {
-            result->alphabet[j++] = ch;
+    memset(seen, 0, sizeof(seen));
+    for (i = 0, j = 0; (ch = alphabet[i]); ++i) {
+        if (!HASHIDS_CHARSET_HAS(seen, ch)) {
+            HASHIDS_CHARSET_ADD(seen, ch);
+            result->prepared[j++] = ch;
         }
     }
-    result->alphabet[j] = '\0';
-
-    /* store alphabet length */
-    result->alphabet_length = j;
+    len = j;
 
     /* check length and whitespace */
-    if (result->alphabet_length < HASHIDS_MIN_ALPHABET_LENGTH) {
-        hashids_free(result);
-        hashids_errno = HASHIDS_ERROR_ALPHABET_LENGTH;
-        return NULL;
+    if (len < HASHIDS_MIN_ALPHABET_LENGTH) {
+        return HASHIDS_ERROR_ALPHABET_LENGTH;
     }
-    if (strchr(result->alphabet, 0x20) || strchr(result->alphabet, 0x09)) {
-        hashids_free(result);
-        hashids_errno = HASHIDS_ERROR_ALPHABET_SPACE;
-        return NULL;
+    if (HASHIDS_CHARSET_HAS(seen, 0x20) || HASHIDS_CHARSET_HAS(seen, 0x09)) {
+        return HASHIDS_ERROR_ALPHABET_SPACE;
     }
 
-    /* copy salt */
-    result->salt_length = salt ? strlen(salt) : 0;
-    result->salt = (char *)_hashids_alloc(result->salt_length + 1);
-    if (HASHIDS_UNLIKELY(!result->salt)) {
-        hashids_free(result);
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return NULL;
+    /* take default separators out of the alphabet in a single pass */
+    memset(separators, 0, sizeof(separators));
+    for (i = 0; i < sizeof(HASHIDS_DEFAULT_SEPARATORS) - 1; ++i) {
+        HASHIDS_CHARSET_ADD(separators, HASHIDS_DEFAULT_SEPARATORS[i]);
     }
-    strncpy(result->salt, salt, result->salt_length);
 
-    /* allocate enough space for separators */
-    len = strlen(HASHIDS_DEFAULT_SEPARATORS);
-    j = (size_t)
-        (ceil((float)result->alphabet_length / HASHIDS_SEPARATOR_DIVISOR) + 1);
-    if (j < len + 1) {
-        j = len + 1;
+    memset(seen, 0, sizeof(seen));
+    for (i = 0, j = 0; i < len; ++i) {
+        ch = result->prepared[i];
+        if (HASHIDS_CHARSET_HAS(separators, ch)) {
+            HASHIDS_CHARSET_ADD(seen, ch);
+        } else {
+            result->prepared[j++] = ch;
+        }
     }
+    result->prepared_alphabet_length = j;
 
-    result->separators = (char *)_hashids_alloc(j);
-    if (HASHIDS_UNLIKELY(!result->separators)) {
-        hashids_free(result);
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return NULL;
+    /* separators follow, in the order of HASHIDS_DEFAULT_SEPARATORS */
+    for (i = 0; i < sizeof(HASHIDS_DEFAULT_SEPARATORS) - 1; ++i) {
+        ch = HASHIDS_DEFAULT_SEPARATORS[i];
+        if (HASHIDS_CHARSET_HAS(seen, ch)) {
+            result->prepared[j++] = ch;
+        }
     }
+    result->prepared[j] = '\0';
+    result->prepared_separators_count = j - result->prepared_alphabet_length;
 
-    /* take default separators out of the alphabet */
-    for (i = 0, j = 0; i < strlen(HASHIDS_DEFAULT_SEPARATORS); ++i) {
-        ch = HASHIDS_DEFAULT_SEPARATORS[i];
+    return HASHIDS_ERROR_OK;
+}
+
+/*
+ * Precompute the lottery-dependent head of the per-number shuffle - the
+ * lottery & the salt part of its salt, a row of swap positions per lottery.
+ */
+static void
+hashids_shuffle_setup(hashids_t *result)
+{
+    size_t lottery, k, n, p, steps_count;
+    unsigned char *steps;
+    char ch;
+
+    /* the lottery, then as much of the salt as fits */
+    steps_count = result->salt_length + 1;
+    if (steps_count > result->alphabet_length - 1) {
+        steps_count = result->alphabet_length - 1;
+    }
+    result->shuffle_steps_count = steps_count;
+
+    /* the running sum of the salt part - the tail continues from it */
+    for (k = 0, p = 0; k + 1 < steps_count; ++k) {
+        p += result->salt[k];
+    }
+    result->shuffle_sum = p;
+
+    steps = result->shuffle_steps;
+    for (lottery = 0; lottery < result->alphabet_length; ++lottery) {
+        ch = result->alphabet[lottery];
+        n = result->alphabet_length - 1;
+        for (k = 0, p = 0; k < steps_count; ++k, --n) {
+            p += ch;
+            *steps++ = (unsigned char)hashids_mod(ch + k + p, n);
+            ch = result->salt[k];
+        }
+    }
+}
 
-        /* check if separator is actually in the used alphabet */
-        if ((p = strchr(result->alphabet, ch))) {
-            result->separators[j++] = ch;
+/* salt-dependent setup: shuffles, guards and derived tables */
+static int
+hashids_setup(hashids_t *result, const char *salt)
+{
+    size_t alphabet_size, separators_size, guards_size, steps_size, pad_size,
+        len;
+    char *p;
 
-            /* remove that separator */
-            memmove(p, p + 1,
-                strlen(result->alphabet) - (p - result->alphabet));
+    result->salt_length = salt ? strlen(salt) : 0;
+    result->alphabet_length = result->prepared_alphabet_length;
+    result->separators_count = result->prepared_separators_count;
+
+    /* size everything the salt touches, so it fits in a single block */
+    alphabet_size = result->alphabet_length + 1;
+    len = result->alphabet_length + result->separators_count;
+    separators_size = (size_t)(ceil((float)len / HASHIDS_SEPARATOR_DIVISOR)
+        + 1);
+    if (separators_size < sizeof(HASHIDS_DEFAULT_SEPARATORS)) {
+        separators_size = sizeof(HASHIDS_DEFAULT_SEPARATORS);
+    }
+    guards_size = hashids_div_ceil_size_t(result->alphabet_length,
+        HASHIDS_GUARD_DIVISOR) + 1;
+
+    steps_size = 0;
+    if (result->tables & HASHIDS_TABLE_SHUFFLE) {
+        len = result->salt_length + 1;
+        if (len > result->alphabet_length) {
+            len = result->alphabet_length;
         }
+        steps_size = result->alphabet_length * len;
     }
 
-    /* store separators length */
-    result->separators_count = j;
+    /* padding templates - the final alphabet is no longer than this one */
+    result->pad_digits_count = 0;
+    if ((result->tables & HASHIDS_TABLE_PAD)
+        && result->min_hash_length > 4
+        && result->min_hash_length <= HASHIDS_PAD_TEMPLATE_MAX) {
+        result->pad_digits_count = result->min_hash_length - 4;
+    }
+    pad_size = result->alphabet_length
+        * hashids_pad_templates_size(result->pad_digits_count);
+
+    result->storage_size = result->salt_length + 1 + alphabet_size
+        + separators_size + guards_size + steps_size + pad_size;
+    p = (char *)hashids_instance_alloc(result, result->storage_size);
+    if (HASHIDS_UNLIKELY(!p)) {
+        return HASHIDS_ERROR_ALLOC;
+    }
+    result->storage = p;
+
+    /* copy salt */
+    result->salt = p;
+    strncpy(result->salt, salt, result->salt_length);
+    p += result->salt_length + 1;
+
+    /* copy the prepared alphabet */
+    result->alphabet = p;
+    memcpy(result->alphabet, result->prepared, result->alphabet_length);
+    p += alphabet_size;
 
-    /* subtract separators count from alphabet length */
-    result->alphabet_length -= result->separators_count;
+    /* copy the prepared separators */
+    result->separators = p;
+    memcpy(result->separators, result->prepared + result->alphabet_length,
+        result->separators_count);
+    p += separators_size;
+
+    /* guards */
+    result->guards = p;
+    p += guards_size;
+
+    /* shuffle steps */
+    result->shuffle_steps = steps_size ? (unsigned char *)p : NULL;
+    p += steps_size;
+
+    /* padding templates */
+    result->pad_templates = pad_size ? (unsigned char *)p : NULL;
 
     /* shuffle the separators */
     if (result->separators_count) {
@@ -344,15 +822,9 @@ hashids_init3(const char *salt, size_t min_hash_length, const char *alphabet)
     hashids_shuffle(result->alphabet, result->alphabet_length,
         result->salt, result->salt_length);
 
-    /* allocate guards */
+    /* count guards */
     result->guards_count = hashids_div_ceil_size_t(result->alphabet_length,
         HASHIDS_GUARD_DIVISOR);
-    result->guards = (char *)_hashids_alloc(result->guards_count + 1);
-    if (HASHIDS_UNLIKELY(!result->guards)) {
-        hashids_free(result);
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return NULL;
-    }
 
     if (HASHIDS_UNLIKELY(result->alphabet_length < 3)) {
         /* take some from separators */
@@ -370,60 +842,147 @@ hashids_init3(const char *salt, size_t min_hash_length, const char *alphabet)
         result->alphabet_length -= result->guards_count;
     }
 
-    /* allocate enough space for the alphabet copies */
-    result->alphabet_copy_1 = (char *)_hashids_alloc(result->alphabet_length +
-        1);
-    result->alphabet_copy_2 = (char *)_hashids_alloc(result->alphabet_length +
-        1);
-    if (HASHIDS_UNLIKELY(!result->alphabet || !result->alphabet_copy_1
-        || !result->alphabet_copy_2)) {
-        hashids_free(result);
+    /* the final alphabet decides the per-number shuffles & the padding */
+    result->shuffle_steps_count = result->shuffle_sum = 0;
+    if (result->shuffle_steps) {
+        hashids_shuffle_setup(result);
+    }
+    if (result->pad_templates) {
+        hashids_pad_setup(result);
+    }
+
+    return HASHIDS_ERROR_OK;
+}
+
+/* common init */
+hashids_t *
+hashids_init5(const char *salt, size_t min_hash_length, const char *alphabet,
+    const hashids_allocator_t *allocator, unsigned int tables)
+{
+    hashids_t *result;
+    int error;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (!allocator) {
+        allocator = &hashids_default_allocator;
+    }
+
+    /* allocate the structure */
+    result = (hashids_t *)allocator->alloc(allocator->ctx, sizeof(hashids_t));
+    if (HASHIDS_UNLIKELY(!result)) {
         hashids_errno = HASHIDS_ERROR_ALLOC;
         return NULL;
     }
+    result->allocator = *allocator;
 
-    /* set min hash length */
+    /* set min hash length & the tables to build */
     result->min_hash_length = min_hash_length;
+    result->tables = tables;
+
+    /* prepare the alphabet, then apply the salt */
+    if ((error = hashids_prepare(result, alphabet)) != HASHIDS_ERROR_OK
+        || (error = hashids_setup(result, salt)) != HASHIDS_ERROR_OK) {
+        hashids_free(result);
+        hashids_errno = error;
+        return NULL;
+    }
 
     /* return result happily */
     return result;
 }
 
-/* init with salt and minimum hash length */
-hashids_t *
-hashids_init2(const char *salt, size_t min_hash_length)
-{
-    return hashids_init3(salt, min_hash_length, HASHIDS_DEFAULT_ALPHABET);
-}
-
-/* init with hash only */
+/* derive an instance from a prepared one, only with a different salt */
 hashids_t *
-hashids_init(const char *salt)
+hashids_derive(const hashids_t *hashids, const char *salt)
 {
-    return hashids_init2(salt, HASHIDS_DEFAULT_MIN_HASH_LENGTH);
-}
+    hashids_t *result;
+    size_t len;
+    int error;
 
-/* estimate buffer size (generic) */
-size_t
-hashids_estimate_encoded_size(hashids_t *hashids,
-    size_t numbers_count, unsigned long long *numbers)
-{
-    size_t i, result_len;
+    hashids_errno = HASHIDS_ERROR_OK;
 
-    for (i = 0, result_len = 1; i < numbers_count; ++i) {
-        if (numbers[i] == 0) {
-            result_len += 2;
-        } else if (numbers[i] == 0xFFFFFFFFFFFFFFFFull) {
-            result_len += hashids_div_ceil_unsigned_short(
-                hashids_log2_64(numbers[i]),
-                hashids_log2_64(hashids->alphabet_length)) - 1;
-        } else {
-            result_len += hashids_div_ceil_unsigned_short(
-                hashids_log2_64(numbers[i] + 1),
-                hashids_log2_64(hashids->alphabet_length));
-        }
+    /* allocate the structure */
+    result = (hashids_t *)hashids->allocator.alloc(hashids->allocator.ctx,
+        sizeof(hashids_t));
+    if (HASHIDS_UNLIKELY(!result)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+    result->allocator = hashids->allocator;
+    result->min_hash_length = hashids->min_hash_length;
+    result->tables = hashids->tables;
+
+    /* reuse the deduplicated & validated alphabet */
+    len = hashids->prepared_alphabet_length
+        + hashids->prepared_separators_count;
+    result->prepared = (char *)hashids_instance_alloc(result, len + 1);
+    if (HASHIDS_UNLIKELY(!result->prepared)) {
+        hashids_free(result);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+    memcpy(result->prepared, hashids->prepared, len);
+    result->prepared_alphabet_length = hashids->prepared_alphabet_length;
+    result->prepared_separators_count = hashids->prepared_separators_count;
+
+    /* apply the new salt */
+    if ((error = hashids_setup(result, salt)) != HASHIDS_ERROR_OK) {
+        hashids_free(result);
+        hashids_errno = error;
+        return NULL;
+    }
+
+    return result;
+}
+
+/* init with salt, minimum hash length, alphabet and allocator */
+hashids_t *
+hashids_init4(const char *salt, size_t min_hash_length, const char *alphabet,
+    const hashids_allocator_t *allocator)
+{
+    return hashids_init5(salt, min_hash_length, alphabet, allocator, 0);
+}
+
+/* init with salt, minimum hash length and alphabet */
+hashids_t *
+hashids_init3(const char *salt, size_t min_hash_length, const char *alphabet)
+{
+    return hashids_init4(salt, min_hash_length, alphabet, NULL);
+}
+
+/* init with salt and minimum hash length */
+hashids_t *
+hashids_init2(const char *salt, size_t min_hash_length)
+{
+    return hashids_init3(salt, min_hash_length, HASHIDS_DEFAULT_ALPHABET);
+}
+
+/* init with hash only */
+hashids_t *
+hashids_init(const char *salt)
+{
+    return hashids_init2(salt, HASHIDS_DEFAULT_MIN_HASH_LENGTH);
+}
+
+/* estimate how many characters a single number takes - its bits over the
+   bits every digit holds at least, so never too few */
+static inline size_t
+hashids_estimate_number_size(hashids_t *hashids, unsigned long long number)
+{
+    if (number == 0) {
+        return 2;
     }
 
+    return hashids_div_ceil_unsigned_short(hashids_log2_64(number) + 1,
+        hashids_log2_64(hashids->alphabet_length));
+}
+
+/* finish an estimation with separators, padding & slack */
+static inline size_t
+hashids_estimate_finish(hashids_t *hashids, size_t numbers_count,
+    size_t result_len)
+{
     if (numbers_count > 1) {
         result_len += numbers_count - 1;
     }
@@ -435,33 +994,53 @@ hashids_estimate_encoded_size(hashids_t *hashids,
     return result_len + 2 /* fast log2 & ceil sometimes undershoot by 1 */;
 }
 
+/* estimate buffer size (generic) */
+size_t
+hashids_estimate_encoded_size(hashids_t *hashids,
+    size_t numbers_count, unsigned long long *numbers)
+{
+    size_t i, result_len;
+
+    for (i = 0, result_len = 1; i < numbers_count; ++i) {
+        result_len += hashids_estimate_number_size(hashids, numbers[i]);
+    }
+
+    return hashids_estimate_finish(hashids, numbers_count, result_len);
+}
+
 /* estimate buffer size (variadic) */
 size_t
 hashids_estimate_encoded_size_v(hashids_t *hashids,
     size_t numbers_count, ...)
 {
-    size_t i, result;
-    unsigned long long *numbers;
+    size_t i, result_len;
     va_list ap;
 
-    numbers = (unsigned long long *)_hashids_alloc(numbers_count *
-        sizeof(unsigned long long));
-
-    if (HASHIDS_UNLIKELY(!numbers)) {
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return 0;
-    }
-
     va_start(ap, numbers_count);
-    for (i = 0; i < numbers_count; ++i) {
-        numbers[i] = va_arg(ap, unsigned long long);
+    for (i = 0, result_len = 1; i < numbers_count; ++i) {
+        result_len += hashids_estimate_number_size(hashids,
+            va_arg(ap, unsigned long long));
     }
     va_end(ap);
 
-    result = hashids_estimate_encoded_size(hashids, numbers_count, numbers);
-    _hashids_free(numbers);
+    return hashids_estimate_finish(hashids, numbers_count, result_len);
+}
 
-    return result;
+/* skip padding - everything up to and including the first guard */
+static inline const char *
+hashids_skip_padding(hashids_t *hashids, const char *str)
+{
+    const char *p;
+
+    if (hashids->min_hash_length) {
+        for (p = str; *p; ++p) {
+            if (strchr(hashids->guards, *p)) {
+                return p + 1;
+            }
+        }
+    }
+
+    return str;
 }
 
 /* encode many (generic) */
@@ -476,20 +1055,17 @@ hashids_encode(hashids_t *hashids, char *buffer,
         return 0;
     }
 
-    size_t i, j, result_len, guard_index, half_length_ceil, half_length_floor;
+    size_t i, j, lottery, result_len;
     unsigned long long number, number_copy, numbers_hash;
-    int p_max;
-    char lottery, ch, temp_ch, *p, *buffer_end, *buffer_temp;
+    char ch, temp_ch, *buffer_end, *buffer_temp;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
 
     /* return an estimation if no buffer */
     if (HASHIDS_UNLIKELY(!buffer)) {
         return hashids_estimate_encoded_size(hashids, numbers_count, numbers);
     }
 
-    /* copy the alphabet into internal buffer 1 */
-    strncpy(hashids->alphabet_copy_1, hashids->alphabet,
-        hashids->alphabet_length);
-
     /* walk arguments once and generate a hash */
     for (i = 0, numbers_hash = 0; i < numbers_count; ++i) {
         number = numbers[i];
@@ -497,43 +1073,28 @@ hashids_encode(hashids_t *hashids, char *buffer,
     }
 
     /* lottery character */
-    lottery = hashids->alphabet[numbers_hash % hashids->alphabet_length];
+    lottery = numbers_hash % hashids->alphabet_length;
 
     /* start output buffer with it (or don't) */
-    buffer[0] = lottery;
+    buffer[0] = hashids->alphabet[lottery];
     buffer_end = buffer + 1;
 
-    /* alphabet-like buffer used for salt at each iteration */
-    hashids->alphabet_copy_2[0] = lottery;
-    hashids->alphabet_copy_2[1] = '\0';
-    strncat(hashids->alphabet_copy_2, hashids->salt,
-        hashids->alphabet_length - 1);
-    p = hashids->alphabet_copy_2 + hashids->salt_length + 1;
-    p_max = hashids->alphabet_length - 1 - hashids->salt_length;
-    if (p_max > 0) {
-        strncat(hashids->alphabet_copy_2, hashids->alphabet,
-            p_max);
-    } else {
-        hashids->alphabet_copy_2[hashids->alphabet_length] = '\0';
-    }
+    /* scratch alphabet for this lottery */
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
 
     for (i = 0; i < numbers_count; ++i) {
         /* take number */
         number = number_copy = numbers[i];
 
-        /* create a salt for this iteration */
-        if (p_max > 0) {
-            strncpy(p, hashids->alphabet_copy_1, p_max);
-        }
-
         /* shuffle the alphabet */
-        hashids_shuffle(hashids->alphabet_copy_1, hashids->alphabet_length,
-            hashids->alphabet_copy_2, hashids->alphabet_length);
+        hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+            alphabet_copy_2);
 
         /* hash the number */
         buffer_temp = buffer_end;
         do {
-            ch = hashids->alphabet_copy_1[number % hashids->alphabet_length];
+            ch = alphabet_copy_1[number % hashids->alphabet_length];
             *buffer_end++ = ch;
             number /= hashids->alphabet_length;
         } while (number);
@@ -554,66 +1115,13 @@ hashids_encode(hashids_t *hashids, char *buffer,
     }
 
     /* intermediate string length */
-    result_len = buffer_end - buffer;
-
-    if (result_len < hashids->min_hash_length) {
-        /* add a guard before the encoded numbers */
-        guard_index = (numbers_hash + buffer[0]) % hashids->guards_count;
-        memmove(buffer + 1, buffer, result_len);
-        buffer[0] = hashids->guards[guard_index];
-        ++result_len;
-
-        if (result_len < hashids->min_hash_length) {
-            /* add a guard after the encoded numbers */
-            guard_index = (numbers_hash + buffer[2]) % hashids->guards_count;
-            buffer[result_len] = hashids->guards[guard_index];
-            ++result_len;
-
-            /* pad with half alphabet before and after */
-            half_length_ceil = hashids_div_ceil_size_t(
-                hashids->alphabet_length, 2);
-            half_length_floor = floor((float)hashids->alphabet_length / 2);
-
-            /* pad, pad, pad */
-            while (result_len < hashids->min_hash_length) {
-                /* shuffle the alphabet */
-                strncpy(hashids->alphabet_copy_2, hashids->alphabet_copy_1,
-                    hashids->alphabet_length);
-                hashids_shuffle(hashids->alphabet_copy_1,
-                    hashids->alphabet_length, hashids->alphabet_copy_2,
-                    hashids->alphabet_length);
-
-                /* left pad from the end of the alphabet */
-                i = hashids_div_ceil_size_t(
-                    hashids->min_hash_length - result_len, 2);
-                /* right pad from the beginning */
-                j = floor((float)(hashids->min_hash_length - result_len) / 2);
-
-                /* check bounds */
-                if (i > half_length_ceil) {
-                    i = half_length_ceil;
-                }
-                if (j > half_length_floor) {
-                    j = half_length_floor;
-                }
-
-                /* handle excessively excessive excess */
-                if ((i + j) % 2 == 0 && hashids->alphabet_length % 2 == 1) {
-                    ++i; --j;
-                }
-
-                /* move the current result to "center" */
-                memmove(buffer + i, buffer, result_len);
-                /* pad left */
-                memmove(buffer,
-                    hashids->alphabet_copy_1 + hashids->alphabet_length - i, i);
-                /* pad right */
-                memmove(buffer + i + result_len, hashids->alphabet_copy_1, j);
-
-                /* increment result_len */
-                result_len += i + j;
-            }
-        }
+    if (numbers_count == 1) {
+        result_len = hashids_encode_pad_one(hashids, buffer,
+            buffer_end - buffer, numbers_hash, lottery, alphabet_copy_1,
+            alphabet_copy_2);
+    } else {
+        result_len = hashids_encode_pad(hashids, buffer, buffer_end - buffer,
+            numbers_hash, alphabet_copy_1, alphabet_copy_2);
     }
 
     buffer[result_len] = '\0';
@@ -626,15 +1134,19 @@ hashids_encode_v(hashids_t *hashids, char *buffer,
     size_t numbers_count, ...)
 {
     size_t i, result;
-    unsigned long long *numbers;
+    unsigned long long numbers_stack[HASHIDS_VA_STACK_NUMBERS], *numbers;
     va_list ap;
 
-    numbers = (unsigned long long *)_hashids_alloc(numbers_count *
-        sizeof(unsigned long long));
+    /* only really long argument lists hit the allocator */
+    numbers = numbers_stack;
+    if (HASHIDS_UNLIKELY(numbers_count > HASHIDS_VA_STACK_NUMBERS)) {
+        numbers = (unsigned long long *)hashids_instance_alloc(hashids,
+            numbers_count * sizeof(unsigned long long));
 
-    if (HASHIDS_UNLIKELY(!numbers)) {
-        hashids_errno = HASHIDS_ERROR_ALLOC;
-        return 0;
+        if (HASHIDS_UNLIKELY(!numbers)) {
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return 0;
+        }
     }
 
     va_start(ap, numbers_count);
@@ -644,7 +1156,9 @@ hashids_encode_v(hashids_t *hashids, char *buffer,
     va_end(ap);
 
     result = hashids_encode(hashids, buffer, numbers_count, numbers);
-    _hashids_free(numbers);
+    if (HASHIDS_UNLIKELY(numbers != numbers_stack)) {
+        hashids_instance_free(hashids, numbers);
+    }
 
     return result;
 }
@@ -657,26 +1171,145 @@ hashids_encode_one(hashids_t *hashids, char *buffer,
     return hashids_encode(hashids, buffer, 1, &number);
 }
 
+/* digits of a number in any alphabet - 64 covers even base 2 */
+#define HASHIDS_FANOUT_DIGITS 64
+
+/* numbers whose digits a fan-out keeps on the stack */
+#define HASHIDS_FANOUT_STACK_NUMBERS 8
+
+/* encode one tuple under many instances sharing an alphabet length */
+size_t
+hashids_encode_fanout(hashids_t **instances, size_t instances_count,
+    char *buffer, size_t buffer_stride, size_t numbers_count,
+    unsigned long long *numbers)
+{
+    hashids_t *hashids;
+    size_t i, j, k, lottery, alphabet_length, length, result_len;
+    unsigned long long number, numbers_hash;
+    unsigned char digits_stack[HASHIDS_FANOUT_STACK_NUMBERS
+        * HASHIDS_FANOUT_DIGITS], *digits, *digit,
+        digits_counts_stack[HASHIDS_FANOUT_STACK_NUMBERS], *digits_counts;
+    char ch, *buffer_start, *buffer_end;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (HASHIDS_UNLIKELY(!instances_count)) {
+        return 0;
+    }
+
+    if (HASHIDS_UNLIKELY(!numbers_count)) {
+        for (k = 0; k < instances_count; ++k) {
+            buffer[k * buffer_stride] = '\0';
+        }
+        return instances_count;
+    }
+
+    /* only really long tuples hit the allocator */
+    digits = digits_stack;
+    digits_counts = digits_counts_stack;
+    if (HASHIDS_UNLIKELY(numbers_count > HASHIDS_FANOUT_STACK_NUMBERS)) {
+        digits = (unsigned char *)hashids_instance_alloc(instances[0],
+            numbers_count * (HASHIDS_FANOUT_DIGITS + 1));
+
+        if (HASHIDS_UNLIKELY(!digits)) {
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return 0;
+        }
+        digits_counts = digits + numbers_count * HASHIDS_FANOUT_DIGITS;
+    }
+
+    /* the salt-independent part - numbers hash, lottery & digits */
+    alphabet_length = instances[0]->alphabet_length;
+    for (i = 0, numbers_hash = 0; i < numbers_count; ++i) {
+        numbers_hash += numbers[i] % (i + 100);
+    }
+    lottery = numbers_hash % alphabet_length;
+
+    for (i = 0, length = numbers_count; i < numbers_count; ++i) {
+        number = numbers[i];
+        digit = digits + (i + 1) * HASHIDS_FANOUT_DIGITS;
+        do {
+            *--digit = number % alphabet_length;
+            number /= alphabet_length;
+        } while (number);
+        digits_counts[i] = digits + (i + 1) * HASHIDS_FANOUT_DIGITS - digit;
+        length += digits_counts[i];
+    }
+
+    /* every hash has to fit its slot - the unpadded length is exact */
+    for (k = 0; k < instances_count; ++k) {
+        hashids = instances[k];
+        if (HASHIDS_UNLIKELY(hashids->alphabet_length != alphabet_length
+            ? buffer_stride < hashids_estimate_encoded_size(hashids,
+                numbers_count, numbers)
+            : buffer_stride <= length
+                || buffer_stride <= hashids->min_hash_length)) {
+            if (HASHIDS_UNLIKELY(digits != digits_stack)) {
+                hashids_instance_free(instances[0], digits);
+            }
+            return 0;
+        }
+    }
+
+    /* the salt-dependent part - shuffles, lookups & padding */
+    for (k = 0; k < instances_count; ++k) {
+        hashids = instances[k];
+        buffer_start = buffer + k * buffer_stride;
+
+        /* a different alphabet length shares nothing */
+        if (HASHIDS_UNLIKELY(hashids->alphabet_length != alphabet_length)) {
+            hashids_encode(hashids, buffer_start, numbers_count, numbers);
+            continue;
+        }
+
+        buffer_start[0] = hashids->alphabet[lottery];
+        buffer_end = buffer_start + 1;
+
+        memcpy(alphabet_copy_1, hashids->alphabet, alphabet_length);
+        alphabet_copy_1[alphabet_length] = '\0';
+
+        for (i = 0; i < numbers_count; ++i) {
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
+
+            digit = digits + (i + 1) * HASHIDS_FANOUT_DIGITS
+                - digits_counts[i];
+            for (j = 0; j < digits_counts[i]; ++j) {
+                *buffer_end++ = alphabet_copy_1[digit[j]];
+            }
+
+            /* the separator is picked by the leading digit */
+            if (i + 1 < numbers_count) {
+                ch = alphabet_copy_1[digit[0]];
+                *buffer_end++ = hashids->separators[numbers[i] % (ch + i)
+                    % hashids->separators_count];
+            }
+        }
+
+        result_len = hashids_encode_pad(hashids, buffer_start,
+            buffer_end - buffer_start, numbers_hash, alphabet_copy_1,
+            alphabet_copy_2);
+        buffer_start[result_len] = '\0';
+    }
+
+    if (HASHIDS_UNLIKELY(digits != digits_stack)) {
+        hashids_instance_free(instances[0], digits);
+    }
+
+    return instances_count;
+}
+
 /* numbers count */
 size_t
 hashids_numbers_count(hashids_t *hashids, const char *str)
 {
     size_t numbers_count;
     char ch;
-    const char *p;
 
     /* skip characters until we find a guard */
-    if (hashids->min_hash_length) {
-        p = str;
-        while ((ch = *p)) {
-            if (strchr(hashids->guards, ch)) {
-                str = p + 1;
-                break;
-            }
-
-            p++;
-        }
-    }
+    str = hashids_skip_padding(hashids, str);
 
     /* parse */
     numbers_count = 0;
@@ -706,52 +1339,32 @@ size_t
 hashids_decode(hashids_t *hashids, const char *str,
     unsigned long long *numbers, size_t numbers_max)
 {
-    size_t numbers_count;
+    size_t numbers_count, lottery;
     unsigned long long number;
-    char lottery, ch, *p, *c;
-    int p_max;
+    char ch, *c;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
 
     if (!numbers || !numbers_max) {
         return hashids_numbers_count(hashids, str);
     }
 
     /* skip characters until we find a guard */
-    if (hashids->min_hash_length) {
-        p = (char *)str;
-        while ((ch = *p)) {
-            if (strchr(hashids->guards, ch)) {
-                str = p + 1;
-                break;
-            }
+    str = hashids_skip_padding(hashids, str);
 
-            p++;
-        }
-    }
-
-    /* get the lottery character */
-    lottery = *str++;
-
-    /* copy the alphabet into internal buffer 1 */
-    strncpy(hashids->alphabet_copy_1, hashids->alphabet,
-        hashids->alphabet_length);
-
-    /* alphabet-like buffer used for salt at each iteration */
-    hashids->alphabet_copy_2[0] = lottery;
-    hashids->alphabet_copy_2[1] = '\0';
-    strncat(hashids->alphabet_copy_2, hashids->salt,
-        hashids->alphabet_length - 1);
-    p = hashids->alphabet_copy_2 + hashids->salt_length + 1;
-    p_max = hashids->alphabet_length - 1 - hashids->salt_length;
-    if (p_max > 0) {
-        strncat(hashids->alphabet_copy_2, hashids->alphabet,
-            p_max);
-    } else {
-        hashids->alphabet_copy_2[hashids->alphabet_length] = '\0';
+    /* get the lottery character - hashids_encode() takes it from alphabet */
+    if (HASHIDS_UNLIKELY(!*str || !(c = strchr(hashids->alphabet, *str)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
     }
+    lottery = c - hashids->alphabet;
+    ++str;
 
-    /* first shuffle */
-    hashids_shuffle(hashids->alphabet_copy_1, hashids->alphabet_length,
-        hashids->alphabet_copy_2, hashids->alphabet_length);
+    /* scratch alphabet for this lottery, first shuffle */
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+    hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+        alphabet_copy_2);
 
     /* parse */
     numbers_count = 0;
@@ -772,22 +1385,19 @@ hashids_decode(hashids_t *hashids, const char *str,
             number = 0;
 
             /* resalt the alphabet */
-            if (p_max > 0) {
-                strncpy(p, hashids->alphabet_copy_1, p_max);
-            }
-            hashids_shuffle(hashids->alphabet_copy_1, hashids->alphabet_length,
-                hashids->alphabet_copy_2, hashids->alphabet_length);
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
 
             str++;
             continue;
         }
-        if (!(c = strchr(hashids->alphabet_copy_1, ch))) {
+        if (!(c = strchr(alphabet_copy_1, ch))) {
             hashids_errno = HASHIDS_ERROR_INVALID_HASH;
             return 0;
         }
 
         number *= hashids->alphabet_length;
-        number += c - hashids->alphabet_copy_1;
+        number += c - alphabet_copy_1;
 
         str++;
     }
@@ -823,7 +1433,7 @@ hashids_decode_safe(hashids_t *hashids, const char *str,
 
     len = hashids_estimate_encoded_size(hashids, numbers_count, numbers);
 
-    p = (char *)_hashids_alloc(len);
+    p = (char *)hashids_instance_alloc(hashids, len);
     if (HASHIDS_UNLIKELY(!p)) {
         hashids_errno = HASHIDS_ERROR_ALLOC;
         return 0;
@@ -831,98 +1441,2807 @@ hashids_decode_safe(hashids_t *hashids, const char *str,
 
     len = hashids_encode(hashids, p, numbers_count, numbers);
     if (HASHIDS_UNLIKELY(!len)) {
-        _hashids_free(p);
+        hashids_instance_free(hashids, p);
         return 0;
     }
 
     if (strcmp(str, p) != 0) {
-        _hashids_free(p);
+        hashids_instance_free(hashids, p);
         hashids_errno = HASHIDS_ERROR_INVALID_HASH;
         return 0;
     }
 
-    _hashids_free(p);
+    hashids_instance_free(hashids, p);
     return numbers_count;
 }
 
-/* encode hex */
+/* re-encodes this long stay on the stack in hashids_decode_bounded() */
+#define HASHIDS_BOUNDED_STACK 256
+
+/* decode untrusted input - at most max_length characters & numbers_max
+   numbers, no overflowing numbers, and only what hashids_encode() gives */
 size_t
-hashids_encode_hex(hashids_t *hashids, char *buffer,
-    const char *hex_str)
+hashids_decode_bounded(hashids_t *hashids, const char *str,
+    unsigned long long *numbers, size_t numbers_max, size_t max_length)
 {
-    int len;
-    char *temp, *p;
-    size_t result;
-    unsigned long long number;
-
-    len = strlen(hex_str);
-    temp = (char *)_hashids_alloc(len + 2);
-
-    if (!temp) {
-        hashids_errno = HASHIDS_ERROR_ALLOC;
+    size_t i, length, numbers_count, lottery, digit, digit_max;
+    unsigned long long number, number_max, numbers_hash;
+    const char *p;
+    char ch, *c, *buffer;
+    char buffer_stack[HASHIDS_BOUNDED_STACK];
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    /* the length first - nothing past max_length + 1 characters is read */
+    for (length = 0; length <= max_length && str[length]; ++length) {
+        /* empty */
+    }
+    if (HASHIDS_UNLIKELY(length > max_length || !numbers_max)) {
+        hashids_errno = HASHIDS_ERROR_LIMIT;
         return 0;
     }
 
-    temp[0] = '1';
-    strncpy(temp + 1, hex_str, len);
-
-    number = strtoull(temp, &p, 16);
+    /* skip characters until we find a guard */
+    p = hashids_skip_padding(hashids, str);
 
-    if (p == temp) {
-        _hashids_free(temp);
-        hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+    /* get the lottery character */
+    if (HASHIDS_UNLIKELY(!*p || !(c = strchr(hashids->alphabet, *p)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
         return 0;
     }
+    lottery = c - hashids->alphabet;
+    ++p;
 
-    result = hashids_encode(hashids, buffer, 1, &number);
-    _hashids_free(temp);
+    /* scratch alphabet for this lottery, first shuffle */
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+    hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+        alphabet_copy_2);
 
-    return result;
-}
+    /* number * alphabet_length + digit overflows past these */
+    number_max = 0xFFFFFFFFFFFFFFFFull / hashids->alphabet_length;
+    digit_max = 0xFFFFFFFFFFFFFFFFull % hashids->alphabet_length;
 
-/* decode hex */
-size_t
-hashids_decode_hex(hashids_t *hashids, char *str, char *output)
-{
-    size_t result, i;
-    unsigned long long number;
-    char ch, *temp;
+    /* parse - every separator is checked against the limit before its
+       shuffle, every digit against overflow */
+    numbers_count = 0;
+    number = 0;
+    while ((ch = *p)) {
+        if (strchr(hashids->guards, ch)) {
+            break;
+        }
+        if (strchr(hashids->separators, ch)) {
+            if (HASHIDS_UNLIKELY(numbers_count + 1 >= numbers_max)) {
+                hashids_errno = HASHIDS_ERROR_LIMIT;
+                return 0;
+            }
+            numbers[numbers_count++] = number;
+            number = 0;
 
-    result = hashids_numbers_count(hashids, str);
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
 
-    if (result != 1) {
-        return 0;
-    }
+            p++;
+            continue;
+        }
+        if (HASHIDS_UNLIKELY(!(c = strchr(alphabet_copy_1, ch)))) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
 
-    result = hashids_decode_unsafe(hashids, str, &number);
+        digit = c - alphabet_copy_1;
+        if (HASHIDS_UNLIKELY(number > number_max
+            || (number == number_max && digit > digit_max))) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+        number = number * hashids->alphabet_length + digit;
 
-    if (result != 1) {
-        return 0;
+        p++;
     }
+    numbers[numbers_count++] = number;
 
-    temp = output;
+    /* the lottery is cheap to check before re-encoding */
+    for (i = 0, numbers_hash = 0; i < numbers_count; ++i) {
+        numbers_hash += numbers[i] % (i + 100);
+    }
+    if (HASHIDS_UNLIKELY(numbers_hash % hashids->alphabet_length
+        != lottery)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
 
+    /* re-encode & compare, as hashids_decode_safe() does */
+    buffer = buffer_stack;
+    if (HASHIDS_UNLIKELY(hashids_estimate_encoded_size(hashids,
+        numbers_count, numbers) > sizeof(buffer_stack))) {
+        buffer = (char *)hashids_instance_alloc(hashids,
+            hashids_estimate_encoded_size(hashids, numbers_count, numbers));
+        if (HASHIDS_UNLIKELY(!buffer)) {
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return 0;
+        }
+    }
+
+    if (hashids_encode(hashids, buffer, numbers_count, numbers) != length
+        || memcmp(buffer, str, length) != 0) {
+        numbers_count = 0;
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+    }
+
+    if (HASHIDS_UNLIKELY(buffer != buffer_stack)) {
+        hashids_instance_free(hashids, buffer);
+    }
+
+    return numbers_count;
+}
+
+/* count the rest of the numbers for hashids_decode_into() */
+static size_t
+hashids_decode_count_rest(hashids_t *hashids, const char *str,
+    size_t numbers_count)
+{
+    char ch;
+
+    for (; (ch = *str) && !strchr(hashids->guards, ch); ++str) {
+        if (strchr(hashids->separators, ch)) {
+            ++numbers_count;
+        } else if (!strchr(hashids->alphabet, ch)) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+    }
+
+    hashids_errno = HASHIDS_ERROR_NEED_SPACE;
+    return numbers_count;
+}
+
+/*
+ * Safe decode in one pass - the separators, the digits & the lottery of an
+ * unpadded hash are checked as they go by instead of re-encoding it. Returns
+ * the real numbers count, which is more than numbers_max if they don't fit.
+ */
+size_t
+hashids_decode_into(hashids_t *hashids, const char *str,
+    unsigned long long *numbers, size_t numbers_max)
+{
+    size_t numbers_count, lottery, digit, digit_max, digits_count, length,
+        left, right;
+    unsigned long long number, number_max, numbers_hash;
+    const unsigned char *row;
+    const char *p, *core;
+    char ch, first, *c, *buffer;
+    char buffer_stack[HASHIDS_BOUNDED_STACK];
+    int padded;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* skip characters until we find a guard */
+    p = hashids_skip_padding(hashids, str);
+    padded = p != str;
+
+    /* get the lottery character */
+    if (HASHIDS_UNLIKELY(!*p || !(c = strchr(hashids->alphabet, *p)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+    lottery = c - hashids->alphabet;
+    core = p++;
+
+    /* no room at all - just count */
+    if (HASHIDS_UNLIKELY(!numbers_max)) {
+        return hashids_decode_count_rest(hashids, p, 1);
+    }
+
+    /* scratch alphabet for this lottery, first shuffle */
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+    hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+        alphabet_copy_2);
+
+    /* number * alphabet_length + digit overflows past these */
+    number_max = 0xFFFFFFFFFFFFFFFFull / hashids->alphabet_length;
+    digit_max = 0xFFFFFFFFFFFFFFFFull % hashids->alphabet_length;
+
+    numbers_count = 0;
+    numbers_hash = 0;
+    number = 0;
+    digits_count = 0;
+    first = 0;
+    while ((ch = *p) && !strchr(hashids->guards, ch)) {
+        if (strchr(hashids->separators, ch)) {
+            /* hashids_encode() picks the separator from the number */
+            if (HASHIDS_UNLIKELY(!digits_count || ch != hashids->separators[
+                number % (first + numbers_count)
+                % hashids->separators_count])) {
+                hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+                return 0;
+            }
+
+            numbers[numbers_count] = number;
+            numbers_hash += number % (numbers_count + 100);
+            ++numbers_count;
+
+            /* there is at least one more */
+            if (HASHIDS_UNLIKELY(numbers_count >= numbers_max)) {
+                return hashids_decode_count_rest(hashids, p + 1,
+                    numbers_count + 1);
+            }
+
+            number = 0;
+            digits_count = 0;
+
+            /* resalt the alphabet */
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
+
+            p++;
+            continue;
+        }
+        if (HASHIDS_UNLIKELY(!(c = strchr(alphabet_copy_1, ch)))) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+
+        /* no leading zeroes, no overflow */
+        digit = c - alphabet_copy_1;
+        if (HASHIDS_UNLIKELY((digits_count == 1 && !number)
+            || number > number_max
+            || (number == number_max && digit > digit_max))) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+        if (!digits_count++) {
+            first = ch;
+        }
+        number = number * hashids->alphabet_length + digit;
+
+        p++;
+    }
+
+    /* the last number */
+    if (HASHIDS_UNLIKELY(!digits_count)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+    numbers[numbers_count] = number;
+    numbers_hash += number % (numbers_count + 100);
+    ++numbers_count;
+
+    if (HASHIDS_UNLIKELY(numbers_hash % hashids->alphabet_length
+        != lottery)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+
+    /* unpadded - no guards, and long enough not to need any */
+    if (HASHIDS_LIKELY(!padded)) {
+        if (HASHIDS_UNLIKELY(*p
+            || (size_t)(p - str) < hashids->min_hash_length)) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+
+        return numbers_count;
+    }
+
+    /* a single number - guards, then the pads against their template */
+    if (numbers_count == 1 && hashids->pad_templates
+        && digits_count <= hashids->pad_digits_count) {
+        row = hashids_pad_template(hashids, lottery, digits_count);
+        left = row[0];
+        right = hashids->min_hash_length - digits_count - 3 - left;
+
+        if (HASHIDS_UNLIKELY((size_t)(core - str) != left + 1
+            || memcmp(str, row + 1, left) != 0
+            || core[-1] != hashids->guards[(numbers_hash + core[0])
+                % hashids->guards_count]
+            || *p != hashids->guards[(numbers_hash + first)
+                % hashids->guards_count]
+            || strncmp(p + 1, (const char *)row + 1 + left, right) != 0
+            || p[1 + right])) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+
+        return numbers_count;
+    }
+
+    /* padded - re-encode & compare, as hashids_decode_safe() does */
+    length = hashids_estimate_encoded_size(hashids, numbers_count, numbers);
+    buffer = buffer_stack;
+    if (HASHIDS_UNLIKELY(length > sizeof(buffer_stack))) {
+        buffer = (char *)hashids_instance_alloc(hashids, length);
+        if (HASHIDS_UNLIKELY(!buffer)) {
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return 0;
+        }
+    }
+
+    hashids_encode(hashids, buffer, numbers_count, numbers);
+    if (strcmp(buffer, str) != 0) {
+        numbers_count = 0;
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+    }
+
+    if (HASHIDS_UNLIKELY(buffer != buffer_stack)) {
+        hashids_instance_free(hashids, buffer);
+    }
+
+    return numbers_count;
+}
+
+/* value of a hex digit, 16 for anything else */
+static inline unsigned int
+hashids_hex_value(char ch)
+{
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    } else if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    } else if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+
+    return 16;
+}
+
+/* parse exactly 16 hex digits, returns 0 on a non-hex character */
+static inline int
+hashids_hex_parse_block(const char *hex, unsigned long long *value)
+{
+#ifdef HASHIDS_HAVE_SSE2
+    __m128i v, digits, letters, is_digit, is_letter, nibbles;
+    unsigned char bytes[8];
+    size_t i;
+
+    v = _mm_loadu_si128((const __m128i *)hex);
+
+    /* unsigned range checks: ch - '0' <= 9, (ch | 0x20) - 'a' <= 5 */
+    digits = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    letters = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)),
+        _mm_set1_epi8('a'));
+    is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)),
+        digits);
+    is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)),
+        letters);
+    if (HASHIDS_UNLIKELY(_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter))
+        != 0xFFFF)) {
+        return 0;
+    }
+
+    nibbles = _mm_or_si128(_mm_and_si128(is_digit, digits),
+        _mm_and_si128(is_letter,
+            _mm_add_epi8(letters, _mm_set1_epi8(10))));
+
+    /* two nibbles per byte, high one first */
+    nibbles = _mm_or_si128(
+        _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0)),
+        _mm_srli_epi16(nibbles, 8));
+    _mm_storel_epi64((__m128i *)bytes, _mm_packus_epi16(nibbles, nibbles));
+
+    for (i = 0, *value = 0; i < 8; ++i) {
+        *value = (*value << 8) | bytes[i];
+    }
+#else
+    unsigned int digit;
+    size_t i;
+
+    for (i = 0, *value = 0; i < 16; ++i) {
+        if (HASHIDS_UNLIKELY((digit = hashids_hex_value(hex[i])) > 15)) {
+            return 0;
+        }
+        *value = (*value << 4) | digit;
+    }
+#endif
+
+    return 1;
+}
+
+/* parse up to 15 hex digits behind a leading 1 nibble */
+static inline int
+hashids_hex_parse_head(const char *hex, size_t length,
+    unsigned long long *value)
+{
+    char block[16];
+
+    memset(block, '0', sizeof(block) - length - 1);
+    block[sizeof(block) - length - 1] = '1';
+    memcpy(block + sizeof(block) - length, hex, length);
+
+    return hashids_hex_parse_block(block, value);
+}
+
+/* format exactly 16 hex digits */
+static inline void
+hashids_hex_format_block(unsigned long long value, char *hex)
+{
+#ifdef HASHIDS_HAVE_SSE2
+    __m128i bytes, nibbles;
+    unsigned char be[8];
+    size_t i;
+
+    for (i = 0; i < 8; ++i) {
+        be[i] = (unsigned char)(value >> (56 - i * 8));
+    }
+    bytes = _mm_loadl_epi64((const __m128i *)be);
+
+    /* high & low nibbles interleaved, then '0' + n (+ 7 past '9') */
+    nibbles = _mm_unpacklo_epi8(
+        _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F)),
+        _mm_and_si128(bytes, _mm_set1_epi8(0x0F)));
+    nibbles = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+        _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+            _mm_set1_epi8('A' - '9' - 1)));
+    _mm_storeu_si128((__m128i *)hex, nibbles);
+#else
+    size_t i;
+
+    for (i = 16; i--; value >>= 4) {
+        hex[i] = "0123456789ABCDEF"[value & 0xF];
+    }
+#endif
+}
+
+/* encode hex */
+size_t
+hashids_encode_hex(hashids_t *hashids, char *buffer,
+    const char *hex_str)
+{
+    unsigned long long number;
+    size_t length;
+
+    /* a leading 1 nibble keeps leading zeroes */
+    length = strlen(hex_str);
+    if (HASHIDS_UNLIKELY(length > 15
+        || !hashids_hex_parse_head(hex_str, length, &number))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+        return 0;
+    }
+
+    return hashids_encode(hashids, buffer, 1, &number);
+}
+
+/* decode hex */
+size_t
+hashids_decode_hex(hashids_t *hashids, char *str, char *output)
+{
+    size_t result, length;
+    unsigned long long number;
+    char block[16];
+
+    result = hashids_numbers_count(hashids, str);
+
+    if (result != 1) {
+        return 0;
+    }
+
+    result = hashids_decode_unsafe(hashids, str, &number);
+
+    if (result != 1) {
+        return 0;
+    }
+
+    /* everything below the leading 1 nibble, formatted in place */
+    length = number ? hashids_log2_64(number) / 4 : 0;
+    hashids_hex_format_block(number, block);
+    memcpy(output, block + sizeof(block) - length, length);
+    output[length] = '\0';
+
+    return 1;
+}
+
+/* a divisor and its reciprocal */
+struct hashids_divisor_s {
+    uint64_t divisor;
+    uint64_t reciprocal;
+};
+
+/* precompute a reciprocal */
+static inline void
+hashids_divisor_init(struct hashids_divisor_s *divisor, uint64_t value)
+{
+    divisor->divisor = value;
+    divisor->reciprocal = 0xFFFFFFFFFFFFFFFFull / value;
+}
+
+/* x / divisor - a multiply and at most two corrections where possible */
+static inline uint64_t
+hashids_divide(const struct hashids_divisor_s *divisor, uint64_t x,
+    uint64_t *remainder)
+{
+    uint64_t quotient;
+
+#ifdef HASHIDS_HAVE_INT128
+    /* the estimate is never too big and at most 2 too small */
+    quotient = (uint64_t)(((unsigned __int128)x * divisor->reciprocal) >> 64);
+    *remainder = x - quotient * divisor->divisor;
+    while (*remainder >= divisor->divisor) {
+        *remainder -= divisor->divisor;
+        ++quotient;
+    }
+#else
+    quotient = x / divisor->divisor;
+    *remainder = x - quotient * divisor->divisor;
+#endif
+
+    return quotient;
+}
+
+/* divisors used to take big numbers apart */
+struct hashids_big_divisors_s {
+    struct hashids_divisor_s base;
+    struct hashids_divisor_s chunk;
+    size_t chunk_digits;
+};
+
+/* the alphabet length & its largest power that fits in a limb */
+static inline void
+hashids_big_divisors_init(hashids_t *hashids,
+    struct hashids_big_divisors_s *divisors)
+{
+    uint64_t chunk;
+    size_t chunk_digits;
+
+    for (chunk = hashids->alphabet_length, chunk_digits = 1;
+        chunk * hashids->alphabet_length <= 0xFFFFFFFFu; ++chunk_digits) {
+        chunk *= hashids->alphabet_length;
+    }
+
+    hashids_divisor_init(&divisors->base, hashids->alphabet_length);
+    hashids_divisor_init(&divisors->chunk, chunk);
+    divisors->chunk_digits = chunk_digits;
+}
+
+/* limbs /= divisor in place, returns the remainder */
+static inline uint32_t
+hashids_big_divmod(uint32_t *limbs, size_t *limbs_count,
+    const struct hashids_divisor_s *divisor)
+{
+    uint64_t remainder;
+    size_t i;
+
+    for (i = *limbs_count, remainder = 0; i--; /* empty */) {
+        limbs[i] = (uint32_t)hashids_divide(divisor,
+            (remainder << 32) | limbs[i], &remainder);
+    }
+
+    /* drop the leading zero limbs */
+    while (*limbs_count && !limbs[*limbs_count - 1]) {
+        --*limbs_count;
+    }
+
+    return (uint32_t)remainder;
+}
+
+/* limbs = limbs * multiplier + addend, returns the new limbs count */
+static inline size_t
+hashids_big_muladd(uint32_t *limbs, size_t limbs_count, uint32_t multiplier,
+    uint32_t addend)
+{
+    uint64_t carry;
+    size_t i;
+
+    for (i = 0, carry = addend; i < limbs_count; ++i) {
+        carry += (uint64_t)limbs[i] * multiplier;
+        limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        limbs[limbs_count++] = (uint32_t)carry;
+    }
+
+    return limbs_count;
+}
+
+/* the hash of a single number is the number modulo 100 */
+static inline unsigned long long
+hashids_big_hash(const uint32_t *limbs, size_t limbs_count)
+{
+    uint64_t remainder;
+
+    for (remainder = 0; limbs_count--; /* empty */) {
+        remainder = ((remainder << 32) | limbs[limbs_count]) % 100;
+    }
+
+    return remainder;
+}
+
+/* digit values, most significant first (consumes the limbs) */
+static size_t
+hashids_big_digits(const struct hashids_big_divisors_s *divisors,
+    char *digits, uint32_t *limbs, size_t limbs_count)
+{
+    uint64_t chunk, digit;
+    size_t i;
+    char temp_ch, *digits_end;
+
+    while (limbs_count && !limbs[limbs_count - 1]) {
+        --limbs_count;
+    }
+    if (!limbs_count) {
+        digits[0] = 0;
+        return 1;
+    }
+
+    /* a whole chunk of digits per pass, least significant first */
+    for (digits_end = digits; limbs_count; /* empty */) {
+        chunk = hashids_big_divmod(limbs, &limbs_count, &divisors->chunk);
+
+        /* inner chunks keep their zeroes, the topmost one doesn't */
+        for (i = 0; i < divisors->chunk_digits && (chunk || limbs_count);
+            ++i) {
+            chunk = hashids_divide(&divisors->base, chunk, &digit);
+            *digits_end++ = (char)digit;
+        }
+    }
+
+    /* reverse the digits we got */
+    for (i = 0; i < (size_t)((digits_end - digits) / 2); ++i) {
+        temp_ch = *(digits + i);
+        *(digits + i) = *(digits_end - 1 - i);
+        *(digits_end - 1 - i) = temp_ch;
+    }
+
+    return digits_end - digits;
+}
+
+/* the alphabet for a single number - set up & shuffled once */
+static inline void
+hashids_lottery_alphabet(hashids_t *hashids, size_t lottery,
+    char *alphabet_copy_1, char *alphabet_copy_2)
+{
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+    hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+        alphabet_copy_2);
+}
+
+/* map the digit values after the lottery & pad - single numbers only */
+static inline size_t
+hashids_encode_single(hashids_t *hashids, char *buffer, size_t digits_count,
+    unsigned long long numbers_hash, char *alphabet_copy_1,
+    char *alphabet_copy_2)
+{
+    size_t i, result_len;
+
+    for (i = 1; i <= digits_count; ++i) {
+        buffer[i] = alphabet_copy_1[(unsigned char)buffer[i]];
+    }
+
+    result_len = hashids_encode_pad(hashids, buffer, digits_count + 1,
+        numbers_hash, alphabet_copy_1, alphabet_copy_2);
+
+    buffer[result_len] = '\0';
+    return result_len;
+}
+
+/* zeroed limbs - on the stack if they fit */
+static inline uint32_t *
+hashids_big_limbs(hashids_t *hashids, uint32_t *limbs_stack,
+    size_t limbs_count)
+{
+    uint32_t *limbs;
+
+    if (HASHIDS_LIKELY(limbs_count <= HASHIDS_BIG_STACK_LIMBS)) {
+        return memset(limbs_stack, 0,
+            HASHIDS_BIG_STACK_LIMBS * sizeof(uint32_t));
+    }
+
+    limbs = (uint32_t *)hashids_instance_alloc(hashids,
+        limbs_count * sizeof(uint32_t));
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+    }
+
+    return limbs;
+}
+
+/* buffer size for a number of the given bit width */
+static inline size_t
+hashids_estimate_big_size(hashids_t *hashids, size_t bits)
+{
+    size_t result_len;
+
+    /* floor(log2()) of the alphabet length gives an upper bound */
+    result_len = 1 + hashids_div_ceil_size_t(bits,
+        hashids_log2_64(hashids->alphabet_length));
+
+    if (result_len < hashids->min_hash_length) {
+        result_len = hashids->min_hash_length;
+    }
+
+    return result_len + 1;
+}
+
+/* encode a single little-endian multi-limb number (consumes the limbs) */
+static size_t
+hashids_encode_big(hashids_t *hashids, char *buffer, uint32_t *limbs,
+    size_t limbs_count)
+{
+    struct hashids_big_divisors_s divisors;
+    unsigned long long numbers_hash;
+    size_t digits_count, lottery;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    numbers_hash = hashids_big_hash(limbs, limbs_count);
+
+    /* digit values go right after the lottery */
+    hashids_big_divisors_init(hashids, &divisors);
+    digits_count = hashids_big_digits(&divisors, buffer + 1, limbs,
+        limbs_count);
+
+    lottery = numbers_hash % hashids->alphabet_length;
+    buffer[0] = hashids->alphabet[lottery];
+    hashids_lottery_alphabet(hashids, lottery, alphabet_copy_1,
+        alphabet_copy_2);
+
+    return hashids_encode_single(hashids, buffer, digits_count, numbers_hash,
+        alphabet_copy_1, alphabet_copy_2);
+}
+
+/*
+ * Whether a decoded single number is spelled the one way the encoder spells
+ * it - the lottery of its value, no leading zero digit and, unless padded,
+ * nothing around it. 1 if it is, 0 if not, -1 if padded (only a re-encode
+ * can tell).
+ */
+static inline int
+hashids_single_canonical(hashids_t *hashids, const char *hash,
+    const char *digits, size_t digits_count, size_t lottery,
+    unsigned long long numbers_hash, const unsigned char *index)
+{
+    if (HASHIDS_UNLIKELY(numbers_hash % hashids->alphabet_length != lottery
+        || (digits_count > 1 && !index[(unsigned char)*digits]))) {
+        return 0;
+    }
+    if (digits_count + 1 < hashids->min_hash_length) {
+        return -1;
+    }
+
+    return digits - 1 == hash && !digits[digits_count];
+}
+
+/* re-encode decoded limbs & compare - for padded hashes */
+static int
+hashids_big_reencode_ok(hashids_t *hashids, const char *str,
+    const uint32_t *limbs, size_t limbs_count)
+{
+    uint32_t copy_stack[HASHIDS_BIG_STACK_LIMBS], *copy;
+    char buffer_stack[HASHIDS_BIG_STACK_HASH], *buffer;
+    size_t size;
+    int result;
+
+    /* one limb more - a zero still has a digit */
+    size = hashids_estimate_big_size(hashids, (limbs_count + 1) * 32);
+    copy = hashids_big_limbs(hashids, copy_stack, limbs_count);
+    buffer = size <= sizeof(buffer_stack) ? buffer_stack
+        : (char *)hashids_instance_alloc(hashids, size);
+
+    result = 0;
+    if (HASHIDS_UNLIKELY(!copy || !buffer)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+    } else {
+        memcpy(copy, limbs, limbs_count * sizeof(uint32_t));
+        hashids_encode_big(hashids, buffer, copy, limbs_count);
+        result = strcmp(str, buffer) == 0;
+        if (HASHIDS_UNLIKELY(!result)) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        }
+    }
+
+    if (HASHIDS_UNLIKELY(copy && copy != copy_stack)) {
+        hashids_instance_free(hashids, copy);
+    }
+    if (HASHIDS_UNLIKELY(buffer && buffer != buffer_stack)) {
+        hashids_instance_free(hashids, buffer);
+    }
+
+    return result;
+}
+
+/* decode a single arbitrary-length number into little-endian limbs */
+static uint32_t *
+hashids_decode_big(hashids_t *hashids, const char *str,
+    uint32_t *limbs_stack, size_t *limbs_count)
+{
+    struct hashids_big_divisors_s divisors;
+    size_t i, length, digits;
+    uint32_t *limbs, base, chunk, multiplier;
+    unsigned char index[256];
+    const char *hash, *lottery;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+    int canonical;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+    base = (uint32_t)hashids->alphabet_length;
+
+    /* skip characters until we find a guard */
+    hash = str;
+    str = hashids_skip_padding(hashids, str);
+    if (HASHIDS_UNLIKELY(!*str
+        || !(lottery = strchr(hashids->alphabet, *str)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return NULL;
+    }
+    ++str;
+
+    /* lottery, first shuffle */
+    hashids_lottery_alphabet(hashids, lottery - hashids->alphabet,
+        alphabet_copy_1, alphabet_copy_2);
+
+    /* digit values */
+    memset(index, 0xFF, sizeof(index));
+    for (i = 0; i < base; ++i) {
+        index[(unsigned char)alphabet_copy_1[i]] = (unsigned char)i;
+    }
+
+    /* a single number - only a guard may end it */
+    for (length = 0; index[(unsigned char)str[length]] != 0xFF; ++length) {
+        /* empty */
+    }
+    if (HASHIDS_UNLIKELY(!length
+        || (str[length] && !strchr(hashids->guards, str[length])))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return NULL;
+    }
+
+    /* digits are less than 8 bits wide */
+    limbs = hashids_big_limbs(hashids, limbs_stack, length / 4 + 2);
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        return NULL;
+    }
+
+    /* a whole chunk of digits per multiply-add */
+    hashids_big_divisors_init(hashids, &divisors);
+    for (i = 0, *limbs_count = 0; i < length; /* empty */) {
+        for (digits = 0, chunk = 0, multiplier = 1;
+            digits < divisors.chunk_digits && i < length; ++digits, ++i) {
+            chunk = chunk * base + index[(unsigned char)str[i]];
+            multiplier *= base;
+        }
+        *limbs_count = hashids_big_muladd(limbs, *limbs_count, multiplier,
+            chunk);
+    }
+
+    /* only one hash per number */
+    canonical = hashids_single_canonical(hashids, hash, str, length,
+        lottery - hashids->alphabet, hashids_big_hash(limbs, *limbs_count),
+        index);
+    if (canonical < 0) {
+        canonical = hashids_big_reencode_ok(hashids, hash, limbs,
+            *limbs_count);
+    } else if (HASHIDS_UNLIKELY(!canonical)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+    }
+    if (HASHIDS_UNLIKELY(!canonical)) {
+        if (limbs != limbs_stack) {
+            hashids_instance_free(hashids, limbs);
+        }
+        return NULL;
+    }
+
+    return limbs;
+}
+
+/* encode an arbitrary-length hex string */
+size_t
+hashids_encode_hex_big(hashids_t *hashids, char *buffer,
+    const char *hex_str)
+{
+    uint32_t limbs_stack[HASHIDS_BIG_STACK_LIMBS], *limbs;
+    unsigned long long value;
+    size_t i, length, blocks, result;
+
+    /* a leading 1 nibble keeps leading zeroes */
+    length = strlen(hex_str);
+    if (!buffer) {
+        return hashids_estimate_big_size(hashids, (length + 1) * 4);
+    }
+
+    /* 16 digits (a pair of limbs) at a time from the end, then the head */
+    blocks = length / 16;
+    limbs = hashids_big_limbs(hashids, limbs_stack, blocks * 2 + 2);
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        return 0;
+    }
+
+    for (i = 0; i <= blocks; ++i) {
+        if (HASHIDS_UNLIKELY(!(i < blocks
+            ? hashids_hex_parse_block(hex_str + length - (i + 1) * 16,
+                &value)
+            : hashids_hex_parse_head(hex_str, length % 16, &value)))) {
+            hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+            result = 0;
+            goto cleanup;
+        }
+
+        limbs[i * 2] = (uint32_t)value;
+        limbs[i * 2 + 1] = (uint32_t)(value >> 32);
+    }
+
+    result = hashids_encode_big(hashids, buffer, limbs, blocks * 2 + 2);
+
+cleanup:
+    if (HASHIDS_UNLIKELY(limbs != limbs_stack)) {
+        hashids_instance_free(hashids, limbs);
+    }
+
+    return result;
+}
+
+/* decode into an arbitrary-length hex string */
+size_t
+hashids_decode_hex_big(hashids_t *hashids, const char *str, char *output,
+    size_t output_size)
+{
+    uint32_t limbs_stack[HASHIDS_BIG_STACK_LIMBS], *limbs, top;
+    size_t i, limbs_count, length;
+    char block[16];
+
+    limbs = hashids_decode_big(hashids, str, limbs_stack, &limbs_count);
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        return 0;
+    }
+
+    /* the topmost nibble has to be the 1 added by the encoder */
+    length = 0;
+    top = 0;
+    if (limbs_count) {
+        for (top = limbs[limbs_count - 1], length = (limbs_count - 1) * 8;
+            top >> 4; top >>= 4) {
+            ++length;
+        }
+    }
+
+    if (HASHIDS_UNLIKELY(top != 1)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        length = 0;
+    } else if (output && length < output_size) {
+        /* pairs of limbs from the end, straight into place */
+        for (i = 0; (i + 1) * 16 <= length; ++i) {
+            hashids_hex_format_block((unsigned long long)limbs[i * 2 + 1] << 32
+                | limbs[i * 2], output + length - (i + 1) * 16);
+        }
+
+        /* the head, minus the leading 1 (the limb past the top is zero) */
+        hashids_hex_format_block((unsigned long long)limbs[i * 2 + 1] << 32
+            | limbs[i * 2], block);
+        memcpy(output, block + 16 - length % 16, length % 16);
+        output[length] = '\0';
+    }
+
+    if (HASHIDS_UNLIKELY(limbs != limbs_stack)) {
+        hashids_instance_free(hashids, limbs);
+    }
+
+    return length;
+}
+
+/* encode an arbitrary-length big-endian byte string */
+size_t
+hashids_encode_bytes(hashids_t *hashids, char *buffer,
+    const unsigned char *bytes, size_t bytes_count)
+{
+    uint32_t limbs_stack[HASHIDS_BIG_STACK_LIMBS], *limbs;
+    size_t i, result;
+
+    /* a leading 0x01 byte keeps leading zeroes */
+    if (!buffer) {
+        return hashids_estimate_big_size(hashids, (bytes_count + 1) * 8);
+    }
+
+    limbs = hashids_big_limbs(hashids, limbs_stack, bytes_count / 4 + 1);
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        return 0;
+    }
+
+    for (i = 0; i < bytes_count; ++i) {
+        limbs[i / 4] |= (uint32_t)bytes[bytes_count - 1 - i] << (i % 4 * 8);
+    }
+    limbs[bytes_count / 4] |= (uint32_t)1 << (bytes_count % 4 * 8);
+
+    result = hashids_encode_big(hashids, buffer, limbs, bytes_count / 4 + 1);
+    if (HASHIDS_UNLIKELY(limbs != limbs_stack)) {
+        hashids_instance_free(hashids, limbs);
+    }
+
+    return result;
+}
+
+/* decode into an arbitrary-length big-endian byte string */
+size_t
+hashids_decode_bytes(hashids_t *hashids, const char *str,
+    unsigned char *bytes, size_t bytes_max)
+{
+    uint32_t limbs_stack[HASHIDS_BIG_STACK_LIMBS], *limbs, top;
+    size_t i, limbs_count, length;
+
+    limbs = hashids_decode_big(hashids, str, limbs_stack, &limbs_count);
+    if (HASHIDS_UNLIKELY(!limbs)) {
+        return 0;
+    }
+
+    /* the topmost byte has to be the 0x01 added by the encoder */
+    length = 0;
+    top = 0;
+    if (limbs_count) {
+        for (top = limbs[limbs_count - 1], length = (limbs_count - 1) * 4;
+            top >> 8; top >>= 8) {
+            ++length;
+        }
+    }
+
+    if (HASHIDS_UNLIKELY(top != 1)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        length = 0;
+    } else if (bytes && length <= bytes_max) {
+        for (i = 0; i < length; ++i) {
+            bytes[length - 1 - i] =
+                (unsigned char)(limbs[i / 4] >> (i % 4 * 8));
+        }
+    }
+
+    if (HASHIDS_UNLIKELY(limbs != limbs_stack)) {
+        hashids_instance_free(hashids, limbs);
+    }
+
+    return length;
+}
+
+/* limbs of a big-endian UUID */
+static inline void
+hashids_uuid_limbs(uint32_t *limbs, const unsigned char *uuid)
+{
+    size_t i;
+
+    for (i = 0; i < 4; ++i, uuid += 4) {
+        limbs[3 - i] = (uint32_t)uuid[0] << 24 | (uint32_t)uuid[1] << 16
+            | (uint32_t)uuid[2] << 8 | (uint32_t)uuid[3];
+    }
+}
+
+/* encode a UUID, with an optional per-lottery alphabet cache */
+static size_t
+hashids_encode_uuid_cached(hashids_t *hashids, char *buffer,
+    const unsigned char *uuid, const struct hashids_big_divisors_s *divisors,
+    char *cache)
+{
+    uint32_t limbs[4];
+    unsigned long long numbers_hash;
+    size_t digits_count, lottery;
+    char *alphabet, *slot;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    hashids_uuid_limbs(limbs, uuid);
+    numbers_hash = hashids_big_hash(limbs, 4);
+    digits_count = hashids_big_digits(divisors, buffer + 1, limbs, 4);
+
+    lottery = numbers_hash % hashids->alphabet_length;
+    buffer[0] = hashids->alphabet[lottery];
+
+    alphabet = alphabet_copy_1;
+    if (!cache) {
+        hashids_lottery_alphabet(hashids, lottery, alphabet_copy_1,
+            alphabet_copy_2);
+    } else {
+        /* the last byte of a slot tells whether it's filled */
+        slot = cache + lottery * (hashids->alphabet_length + 1);
+        if (!slot[hashids->alphabet_length]) {
+            hashids_lottery_alphabet(hashids, lottery, slot,
+                alphabet_copy_2);
+            slot[hashids->alphabet_length] = 1;
+        }
+
+        /* padding shuffles the alphabet further */
+        if (hashids->min_hash_length) {
+            memcpy(alphabet_copy_1, slot, hashids->alphabet_length);
+        } else {
+            alphabet = slot;
+        }
+    }
+
+    return hashids_encode_single(hashids, buffer, digits_count, numbers_hash,
+        alphabet, alphabet_copy_2);
+}
+
+/* decode a UUID, with optional per-lottery digit value & alphabet caches
+   (the latter for re-encoding padded hashes) */
+static size_t
+hashids_decode_uuid_cached(hashids_t *hashids, const char *str,
+    unsigned char *uuid, const struct hashids_big_divisors_s *divisors,
+    unsigned char *cache, char *alphabets)
+{
+    size_t i, digits, limbs_count, size;
+    uint32_t limbs[5], base, chunk, multiplier;
+    unsigned char index_stack[256], *index, value[HASHIDS_UUID_SIZE], *p;
+    const char *hash, *lottery, *digits_start;
+    char buffer_stack[HASHIDS_UUID_BUFFER_SIZE], *buffer;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+    int ok;
+
+    base = (uint32_t)hashids->alphabet_length;
+
+    /* skip characters until we find a guard */
+    hash = str;
+    str = hashids_skip_padding(hashids, str);
+    if (HASHIDS_UNLIKELY(!*str
+        || !(lottery = strchr(hashids->alphabet, *str)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+
+    /* digit values for this lottery - the last byte tells whether filled */
+    index = cache ? cache + (lottery - hashids->alphabet) * 257 : index_stack;
+    if (!cache || !index[256]) {
+        hashids_lottery_alphabet(hashids, lottery - hashids->alphabet,
+            alphabet_copy_1, alphabet_copy_2);
+        memset(index, 0xFF, 256);
+        for (i = 0; i < base; ++i) {
+            index[(unsigned char)alphabet_copy_1[i]] = (unsigned char)i;
+        }
+        if (cache) {
+            index[256] = 1;
+        }
+    }
+
+    /* a whole chunk of digits per multiply-add, no more than 128 bits */
+    for (digits_start = ++str, limbs_count = 0;
+        index[(unsigned char)*str] != 0xFF; /* empty */) {
+        for (digits = 0, chunk = 0, multiplier = 1;
+            digits < divisors->chunk_digits
+            && index[(unsigned char)*str] != 0xFF; ++digits, ++str) {
+            chunk = chunk * base + index[(unsigned char)*str];
+            multiplier *= base;
+        }
+
+        limbs_count = hashids_big_muladd(limbs, limbs_count, multiplier,
+            chunk);
+        if (HASHIDS_UNLIKELY(limbs_count > 4)) {
+            hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+            return 0;
+        }
+    }
+
+    /* a single number - only a guard may end it */
+    if (HASHIDS_UNLIKELY(str == digits_start
+        || (*str && !strchr(hashids->guards, *str)))) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+
+    for (i = limbs_count; i < 4; ++i) {
+        limbs[i] = 0;
+    }
+    for (i = 0, p = value; i < 4; ++i, p += 4) {
+        p[0] = (unsigned char)(limbs[3 - i] >> 24);
+        p[1] = (unsigned char)(limbs[3 - i] >> 16);
+        p[2] = (unsigned char)(limbs[3 - i] >> 8);
+        p[3] = (unsigned char)limbs[3 - i];
+    }
+
+    /* only one hash per UUID */
+    ok = hashids_single_canonical(hashids, hash, digits_start,
+        str - digits_start, lottery - hashids->alphabet,
+        hashids_big_hash(limbs, 4), index);
+    if (ok > 0) {
+        memcpy(uuid, value, HASHIDS_UUID_SIZE);
+        return 1;
+    }
+    if (HASHIDS_UNLIKELY(!ok)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+
+    /* padded - re-encode & compare */
+    size = hashids_estimate_big_size(hashids, HASHIDS_UUID_SIZE * 8);
+    buffer = size <= sizeof(buffer_stack) ? buffer_stack
+        : (char *)hashids_instance_alloc(hashids, size);
+    if (HASHIDS_UNLIKELY(!buffer)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return 0;
+    }
+    hashids_encode_uuid_cached(hashids, buffer, value, divisors, alphabets);
+    ok = strcmp(hash, buffer) == 0;
+    if (HASHIDS_UNLIKELY(buffer != buffer_stack)) {
+        hashids_instance_free(hashids, buffer);
+    }
+    if (HASHIDS_UNLIKELY(!ok)) {
+        hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+        return 0;
+    }
+
+    memcpy(uuid, value, HASHIDS_UUID_SIZE);
+    return 1;
+}
+
+/* encode a 16-byte binary UUID */
+size_t
+hashids_encode_uuid(hashids_t *hashids, char *buffer,
+    const unsigned char *uuid)
+{
+    struct hashids_big_divisors_s divisors;
+
+    if (!buffer) {
+        return hashids_estimate_big_size(hashids, HASHIDS_UUID_SIZE * 8);
+    }
+
+    hashids_big_divisors_init(hashids, &divisors);
+    return hashids_encode_uuid_cached(hashids, buffer, uuid, &divisors, NULL);
+}
+
+/* decode into a 16-byte binary UUID */
+size_t
+hashids_decode_uuid(hashids_t *hashids, const char *str,
+    unsigned char *uuid)
+{
+    struct hashids_big_divisors_s divisors;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+    hashids_big_divisors_init(hashids, &divisors);
+    return hashids_decode_uuid_cached(hashids, str, uuid, &divisors, NULL,
+        NULL);
+}
+
+/* encode a column of UUIDs into fixed-size slots */
+size_t
+hashids_encode_uuid_batch(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned char *uuids, size_t uuids_count)
+{
+    struct hashids_big_divisors_s divisors;
+    size_t i;
+    char *cache;
+
+    if (HASHIDS_UNLIKELY(buffer_stride
+        < hashids_estimate_big_size(hashids, HASHIDS_UUID_SIZE * 8))) {
+        return 0;
+    }
+
+    /* shuffled alphabets per lottery - no cache is slower, not wrong */
+    cache = (char *)hashids_instance_alloc(hashids,
+        hashids->alphabet_length * (hashids->alphabet_length + 1));
+
+    hashids_big_divisors_init(hashids, &divisors);
+    for (i = 0; i < uuids_count; ++i) {
+        hashids_encode_uuid_cached(hashids, buffer + i * buffer_stride,
+            uuids + i * HASHIDS_UUID_SIZE, &divisors, cache);
+    }
+
+    if (cache) {
+        hashids_instance_free(hashids, cache);
+    }
+
+    return uuids_count;
+}
+
+/* decode a column of fixed-size slots into UUIDs, up to the first error */
+size_t
+hashids_decode_uuid_batch(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned char *uuids)
+{
+    struct hashids_big_divisors_s divisors;
+    size_t i;
+    unsigned char *cache;
+    char *alphabets;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* digit values & shuffled alphabets (to re-encode padded hashes) per
+       lottery - no caches is slower, not wrong */
+    cache = (unsigned char *)hashids_instance_alloc(hashids,
+        hashids->alphabet_length * 257);
+    alphabets = !hashids->min_hash_length ? NULL
+        : (char *)hashids_instance_alloc(hashids,
+            hashids->alphabet_length * (hashids->alphabet_length + 1));
+
+    hashids_big_divisors_init(hashids, &divisors);
+    for (i = 0; i < strs_count; ++i) {
+        if (HASHIDS_UNLIKELY(!hashids_decode_uuid_cached(hashids,
+            strs + i * strs_stride, uuids + i * HASHIDS_UUID_SIZE,
+            &divisors, cache, alphabets))) {
+            break;
+        }
+    }
+
+    if (cache) {
+        hashids_instance_free(hashids, cache);
+    }
+    if (alphabets) {
+        hashids_instance_free(hashids, alphabets);
+    }
+
+    return i;
+}
+
+/*
+ * Single numbers in a batch: chunks of digits small enough that x / base is
+ * a 32-bit multiply (chunk * base <= 2^32), and a shuffled alphabet per
+ * lottery.
+ */
+struct hashids_batch_s {
+    struct hashids_divisor_s chunk;
+    uint32_t base;
+    uint32_t reciprocal;
+    size_t chunk_digits;
+    size_t chunks_count;
+    unsigned char lotteries[100];
+    char *cache;
+};
+
+/* set up a batch - no cache is slower, not wrong */
+static void
+hashids_batch_init(hashids_t *hashids, struct hashids_batch_s *batch,
+    char *cache)
+{
+    uint64_t chunk, rest;
+    size_t i;
+
+    batch->base = (uint32_t)hashids->alphabet_length;
+    batch->reciprocal = (uint32_t)((0xFFFFFFFFull + batch->base)
+        / batch->base);
+
+    for (chunk = batch->base, batch->chunk_digits = 1;
+        chunk * batch->base * batch->base <= 0x100000000ull;
+        ++batch->chunk_digits) {
+        chunk *= batch->base;
+    }
+    hashids_divisor_init(&batch->chunk, chunk);
+
+    /* chunks in the largest number */
+    for (rest = 0xFFFFFFFFFFFFFFFFull / chunk, batch->chunks_count = 1; rest;
+        rest /= chunk) {
+        ++batch->chunks_count;
+    }
+
+    /* a single number's lottery only depends on number % 100 */
+    for (i = 0; i < sizeof(batch->lotteries); ++i) {
+        batch->lotteries[i] = (unsigned char)(i % batch->base);
+    }
+
+    batch->cache = cache;
+}
+
+/* split a number into chunks, least significant first */
+static inline void
+hashids_batch_chunks(const struct hashids_batch_s *batch,
+    unsigned long long number, uint32_t *chunks, size_t chunks_stride)
+{
+    uint64_t remainder;
+    size_t i;
+
+    for (i = 0; i < batch->chunks_count; ++i, chunks += chunks_stride) {
+        if (number) {
+            number = hashids_divide(&batch->chunk, number, &remainder);
+            *chunks = (uint32_t)remainder;
+        } else {
+            *chunks = 0;
+        }
+    }
+}
+
+/* digit values of a chunk, least significant first */
+static inline void
+hashids_batch_digits(const struct hashids_batch_s *batch, uint32_t chunk,
+    uint32_t *digits)
+{
+    uint32_t quotient;
+    size_t i;
+
+    for (i = 0; i < batch->chunk_digits; ++i) {
+        quotient = (uint32_t)(((uint64_t)chunk * batch->reciprocal) >> 32);
+        digits[i] = chunk - quotient * batch->base;
+        chunk = quotient;
+    }
+}
+
+#ifdef HASHIDS_HAVE_AVX2
+/* digit values of a chunk of HASHIDS_BATCH_LANES numbers at once */
+__attribute__((target("avx2")))
+static void
+hashids_batch_digits_avx2(const struct hashids_batch_s *batch,
+    const uint32_t *chunks, uint32_t *digits)
+{
+    __m256i x, quotient, even, odd, base, reciprocal;
+    size_t i;
+
+    base = _mm256_set1_epi32((int)batch->base);
+    reciprocal = _mm256_set1_epi32((int)batch->reciprocal);
+    x = _mm256_loadu_si256((const __m256i *)chunks);
+
+    for (i = 0; i < batch->chunk_digits; ++i) {
+        /* the high halves of the 32x32-bit products, even & odd lanes */
+        even = _mm256_srli_epi64(_mm256_mul_epu32(x, reciprocal), 32);
+        odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), reciprocal);
+        quotient = _mm256_blend_epi32(even, odd, 0xAA);
+
+        _mm256_storeu_si256((__m256i *)(digits + i * HASHIDS_BATCH_LANES),
+            _mm256_sub_epi32(x, _mm256_mullo_epi32(quotient, base)));
+        x = quotient;
+    }
+}
+#endif
+
+/* the shuffled alphabet of a lottery - cached, or computed into alphabet */
+static inline const char *
+hashids_batch_alphabet(hashids_t *hashids, const struct hashids_batch_s *batch,
+    size_t lottery, char *alphabet)
+{
+    char *slot;
+    char alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    if (!batch->cache) {
+        hashids_lottery_alphabet(hashids, lottery, alphabet, alphabet_copy_2);
+        return alphabet;
+    }
+
+    /* the last byte of a slot tells whether it's filled */
+    slot = batch->cache + lottery * (hashids->alphabet_length + 1);
+    if (HASHIDS_UNLIKELY(!slot[hashids->alphabet_length])) {
+        hashids_lottery_alphabet(hashids, lottery, slot, alphabet_copy_2);
+        slot[hashids->alphabet_length] = 1;
+    }
+
+    return slot;
+}
+
+/* lottery, digits through the lottery's alphabet & padding */
+static size_t
+hashids_batch_write(hashids_t *hashids, char *buffer,
+    unsigned long long number, const uint32_t *digits, size_t digits_stride,
+    const struct hashids_batch_s *batch, size_t lottery, const char *alphabet)
+{
+    size_t i, result_len;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    /* drop the leading zeros */
+    result_len = batch->chunks_count * batch->chunk_digits;
+    while (result_len > 1 && !digits[(result_len - 1) * digits_stride]) {
+        --result_len;
+    }
+
+    /* lottery, then the digits from the most significant one */
+    buffer[0] = hashids->alphabet[lottery];
+    for (i = 1, digits += (result_len - 1) * digits_stride; i <= result_len;
+        ++i, digits -= digits_stride) {
+        buffer[i] = alphabet[*digits];
+    }
+    ++result_len;
+
+    /* padding shuffles the alphabet further */
+    if (HASHIDS_UNLIKELY(result_len < hashids->min_hash_length)) {
+        memcpy(alphabet_copy_1, alphabet, hashids->alphabet_length);
+        result_len = hashids_encode_pad_one(hashids, buffer, result_len,
+            number % 100, lottery, alphabet_copy_1, alphabet_copy_2);
+    }
+
+    buffer[result_len] = '\0';
+    return result_len;
+}
+
+/* encode a number from its digits */
+static inline size_t
+hashids_batch_finish(hashids_t *hashids, char *buffer,
+    unsigned long long number, const uint32_t *digits, size_t digits_stride,
+    const struct hashids_batch_s *batch)
+{
+    size_t lottery;
+    char alphabet[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    lottery = batch->lotteries[number % 100];
+
+    return hashids_batch_write(hashids, buffer, number, digits, digits_stride,
+        batch, lottery, hashids_batch_alphabet(hashids, batch, lottery,
+            alphabet));
+}
+
+/* encode single numbers into slots known to be large enough */
+static void
+hashids_batch_encode(hashids_t *hashids, const struct hashids_batch_s *batch,
+    char *buffer, size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count)
+{
+    uint32_t chunks[HASHIDS_BATCH_MAX_DIGITS],
+        digits[HASHIDS_BATCH_MAX_DIGITS * HASHIDS_BATCH_LANES];
+    size_t i, j;
+
+    i = 0;
+#ifdef HASHIDS_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        for (/* empty */; i + HASHIDS_BATCH_LANES <= numbers_count;
+            i += HASHIDS_BATCH_LANES) {
+            /* chunks of all the lanes, then the digits a chunk at a time */
+            for (j = 0; j < HASHIDS_BATCH_LANES; ++j) {
+                hashids_batch_chunks(batch, numbers[i + j], chunks + j,
+                    HASHIDS_BATCH_LANES);
+            }
+            for (j = 0; j < batch->chunks_count; ++j) {
+                hashids_batch_digits_avx2(batch,
+                    chunks + j * HASHIDS_BATCH_LANES, digits
+                    + j * batch->chunk_digits * HASHIDS_BATCH_LANES);
+            }
+
+            for (j = 0; j < HASHIDS_BATCH_LANES; ++j) {
+                hashids_batch_finish(hashids,
+                    buffer + (i + j) * buffer_stride, numbers[i + j],
+                    digits + j, HASHIDS_BATCH_LANES, batch);
+            }
+        }
+    }
+#endif
+
+    /* scalar, and whatever doesn't fill the lanes */
+    for (/* empty */; i < numbers_count; ++i) {
+        hashids_batch_chunks(batch, numbers[i], chunks, 1);
+        for (j = 0; j < batch->chunks_count; ++j) {
+            hashids_batch_digits(batch, chunks[j],
+                digits + j * batch->chunk_digits);
+        }
+        hashids_batch_finish(hashids, buffer + i * buffer_stride, numbers[i],
+            digits, 1, batch);
+    }
+}
+
+/* encode single numbers into fixed-size slots */
+size_t
+hashids_encode_one_batch(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count)
+{
+    struct hashids_batch_s batch;
+    unsigned long long largest = 0xFFFFFFFFFFFFFFFFull;
+    char *cache;
+
+    if (HASHIDS_UNLIKELY(buffer_stride
+        < hashids_estimate_encoded_size(hashids, 1, &largest))) {
+        return 0;
+    }
+
+    cache = (char *)hashids_instance_alloc(hashids,
+        hashids->alphabet_length * (hashids->alphabet_length + 1));
+    hashids_batch_init(hashids, &batch, cache);
+
+    hashids_batch_encode(hashids, &batch, buffer, buffer_stride, numbers,
+        numbers_count);
+
+    if (cache) {
+        hashids_instance_free(hashids, cache);
+    }
+
+    return numbers_count;
+}
+
+/* slots bucketed by lottery at a time */
+#define HASHIDS_BATCH_BLOCK 16384u
+
+/* the tables a batch decode needs on top of a batch */
+struct hashids_batch_decode_s {
+    unsigned char positions[256];
+    unsigned char guards[256];
+    unsigned char *values;
+    char *buffer;
+    uint32_t *order;
+    size_t order_size;
+    uint64_t limit;
+};
+
+/* scratch of a batch decode - the bucket order, a re-encoding buffer &
+   optionally shuffled alphabets & digit values of every lottery */
+static inline size_t
+hashids_batch_decode_size(hashids_t *hashids, size_t order_size, int cached)
+{
+    size_t result;
+
+    result = order_size * sizeof(uint32_t)
+        + (hashids->min_hash_length > HASHIDS_BATCH_MAX_DIGITS + 1
+            ? hashids->min_hash_length + 1 : HASHIDS_BATCH_MAX_DIGITS + 2);
+    if (cached) {
+        result += hashids->alphabet_length * (hashids->alphabet_length + 1
+            + 257);
+    }
+
+    /* keep the next one aligned */
+    return (result + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+/* set up a batch & a batch decode over hashids_batch_decode_size() bytes */
+static void
+hashids_batch_decode_init(hashids_t *hashids,
+    struct hashids_batch_decode_s *decode, struct hashids_batch_s *batch,
+    char *scratch, size_t order_size, int cached)
+{
+    size_t i;
+
+    memset(decode->positions, 0xFF, sizeof(decode->positions));
+    for (i = 0; i < hashids->alphabet_length; ++i) {
+        decode->positions[(unsigned char)hashids->alphabet[i]] =
+            (unsigned char)i;
+    }
+
+    memset(decode->guards, 0, sizeof(decode->guards));
+    for (i = 0; i < hashids->guards_count; ++i) {
+        decode->guards[(unsigned char)hashids->guards[i]] = 1;
+    }
+
+    decode->order = (uint32_t *)scratch;
+    decode->order_size = order_size;
+    scratch += order_size * sizeof(uint32_t);
+
+    if (cached) {
+        hashids_batch_init(hashids, batch, scratch);
+        scratch += hashids->alphabet_length * (hashids->alphabet_length + 1);
+        decode->values = (unsigned char *)scratch;
+        scratch += hashids->alphabet_length * 257;
+    } else {
+        hashids_batch_init(hashids, batch, NULL);
+        decode->values = NULL;
+    }
+
+    decode->buffer = scratch;
+    decode->limit = 0xFFFFFFFFFFFFFFFFull / batch->chunk.divisor;
+}
+
+/* past the padding & the lottery of a hash - NULL if there is no lottery */
+static inline const char *
+hashids_batch_lottery(hashids_t *hashids,
+    const struct hashids_batch_decode_s *decode, const char *str,
+    size_t *lottery)
+{
+    const char *p;
+
+    /* skip characters until we find a guard */
+    if (hashids->min_hash_length) {
+        for (p = str; *p; ++p) {
+            if (decode->guards[(unsigned char)*p]) {
+                str = p + 1;
+                break;
+            }
+        }
+    }
+
+    *lottery = decode->positions[(unsigned char)*str];
+
+    return *lottery == 0xFF ? NULL : str + 1;
+}
+
+/* digit values of a single-number hash, least significant first */
+static int
+hashids_batch_parse(const char *str, const struct hashids_batch_s *batch,
+    const struct hashids_batch_decode_s *decode, const unsigned char *values,
+    uint32_t *digits, size_t digits_stride)
+{
+    size_t i, length, digits_max;
+
+    /* a single number - only a guard may end it */
+    digits_max = batch->chunks_count * batch->chunk_digits;
+    for (length = 0; str[length] && !decode->guards[(unsigned char)str[length]];
+        ++length) {
+        if (HASHIDS_UNLIKELY(values[(unsigned char)str[length]] == 0xFF
+            || length == digits_max)) {
+            return 0;
+        }
+    }
+    if (HASHIDS_UNLIKELY(!length)) {
+        return 0;
+    }
+
+    for (i = 0; i < digits_max; ++i, digits += digits_stride) {
+        *digits = i < length
+            ? values[(unsigned char)str[length - 1 - i]] : 0;
+    }
+
+    return 1;
+}
+
+/* chunk values from digit values */
+static inline uint32_t
+hashids_batch_value(const struct hashids_batch_s *batch,
+    const uint32_t *digits, size_t digits_stride)
+{
+    uint32_t result;
+    size_t i;
+
+    for (i = batch->chunk_digits, result = 0; i--; /* empty */) {
+        result = result * batch->base + digits[i * digits_stride];
+    }
+
+    return result;
+}
+
+#ifdef HASHIDS_HAVE_AVX2
+/* chunk values of HASHIDS_BATCH_LANES numbers at once */
+__attribute__((target("avx2")))
+static void
+hashids_batch_values_avx2(const struct hashids_batch_s *batch,
+    const uint32_t *digits, uint32_t *chunks)
+{
+    __m256i result, base;
+    size_t i;
+
+    base = _mm256_set1_epi32((int)batch->base);
+    result = _mm256_setzero_si256();
+
+    for (i = batch->chunk_digits; i--; /* empty */) {
+        result = _mm256_add_epi32(_mm256_mullo_epi32(result, base),
+            _mm256_loadu_si256((const __m256i *)(digits
+                + i * HASHIDS_BATCH_LANES)));
+    }
+
+    _mm256_storeu_si256((__m256i *)chunks, result);
+}
+#endif
+
+/* the number from its chunks, re-encoded to make sure the hash is its own */
+static int
+hashids_batch_check(hashids_t *hashids, const char *str,
+    unsigned long long *number, const uint32_t *chunks, size_t chunks_stride,
+    const uint32_t *digits, size_t digits_stride,
+    const struct hashids_batch_s *batch,
+    const struct hashids_batch_decode_s *decode, size_t lottery,
+    const char *alphabet)
+{
+    uint64_t result;
+    size_t i;
+
+    for (i = batch->chunks_count, result = 0; i--; /* empty */) {
+        /* past 64 bits */
+        if (HASHIDS_UNLIKELY(result > decode->limit
+            || (result == decode->limit && chunks[i * chunks_stride]
+                > 0xFFFFFFFFFFFFFFFFull - result * batch->chunk.divisor))) {
+            return 0;
+        }
+        result = result * batch->chunk.divisor + chunks[i * chunks_stride];
+    }
+
+    /* no overflow, so the digits are the number's own */
+    if (HASHIDS_UNLIKELY(batch->lotteries[result % 100] != lottery)) {
+        return 0;
+    }
+    hashids_batch_write(hashids, decode->buffer, result, digits,
+        digits_stride, batch, lottery, alphabet);
+    if (strcmp(decode->buffer, str) != 0) {
+        return 0;
+    }
+
+    *number = result;
+    return 1;
+}
+
+/* decode the hashes of a lottery bucket, the count of valid ones */
+static size_t
+hashids_batch_bucket(hashids_t *hashids, const struct hashids_batch_s *batch,
+    const struct hashids_batch_decode_s *decode, size_t lottery,
+    const char *strs, size_t strs_stride, const uint32_t *order,
+    size_t order_count, unsigned long long *numbers, unsigned char *valid)
+{
+    uint32_t chunks[HASHIDS_BATCH_MAX_DIGITS],
+        digits[HASHIDS_BATCH_MAX_DIGITS * HASHIDS_BATCH_LANES];
+    size_t i, j, k, same, result;
+    const char *alphabet, *str;
+    unsigned char *values;
+    unsigned char values_copy[257];
+    char alphabet_copy[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    /* the bucket's tables - the last byte of the values tells if filled */
+    alphabet = hashids_batch_alphabet(hashids, batch, lottery, alphabet_copy);
+    values = decode->values ? decode->values + lottery * 257 : values_copy;
+    if (!decode->values || !values[256]) {
+        memset(values, 0xFF, 256);
+        for (i = 0; i < hashids->alphabet_length; ++i) {
+            values[(unsigned char)alphabet[i]] = (unsigned char)i;
+        }
+        values[256] = 1;
+    }
+
+    i = result = 0;
+#ifdef HASHIDS_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        for (/* empty */; i + HASHIDS_BATCH_LANES <= order_count;
+            i += HASHIDS_BATCH_LANES) {
+            /* digits of all the lanes, then the chunks a chunk at a time */
+            for (j = 0; j < HASHIDS_BATCH_LANES; ++j) {
+                k = order[i + j];
+                str = hashids_batch_lottery(hashids, decode,
+                    strs + k * strs_stride, &same);
+                valid[k] = (unsigned char)hashids_batch_parse(str, batch,
+                    decode, values, digits + j, HASHIDS_BATCH_LANES);
+            }
+            for (j = 0; j < batch->chunks_count; ++j) {
+                hashids_batch_values_avx2(batch, digits
+                    + j * batch->chunk_digits * HASHIDS_BATCH_LANES,
+                    chunks + j * HASHIDS_BATCH_LANES);
+            }
+
+            for (j = 0; j < HASHIDS_BATCH_LANES; ++j) {
+                k = order[i + j];
+                numbers[k] = 0;
+                valid[k] = valid[k] && hashids_batch_check(hashids,
+                    strs + k * strs_stride, numbers + k, chunks + j,
+                    HASHIDS_BATCH_LANES, digits + j, HASHIDS_BATCH_LANES,
+                    batch, decode, lottery, alphabet);
+                result += valid[k];
+            }
+        }
+    }
+#endif
+
+    /* scalar, and whatever doesn't fill the lanes */
+    for (/* empty */; i < order_count; ++i) {
+        k = order[i];
+        str = hashids_batch_lottery(hashids, decode, strs + k * strs_stride,
+            &same);
+        numbers[k] = 0;
+        valid[k] = (unsigned char)hashids_batch_parse(str, batch, decode,
+            values, digits, 1);
+        if (valid[k]) {
+            for (j = 0; j < batch->chunks_count; ++j) {
+                chunks[j] = hashids_batch_value(batch,
+                    digits + j * batch->chunk_digits, 1);
+            }
+            valid[k] = (unsigned char)hashids_batch_check(hashids,
+                strs + k * strs_stride, numbers + k, chunks, 1, digits, 1,
+                batch, decode, lottery, alphabet);
+        }
+        result += valid[k];
+    }
+
+    return result;
+}
+
+/* decode single-number hashes a block at a time, grouped by lottery so that
+   every lottery's tables are set up once - the count of valid ones */
+static size_t
+hashids_batch_decode(hashids_t *hashids, const struct hashids_batch_s *batch,
+    const struct hashids_batch_decode_s *decode, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid)
+{
+    size_t i, block, block_count, begin, end, lottery, result;
+    size_t offsets[256];
+
+    for (block = 0, result = 0; block < strs_count;
+        block += decode->order_size) {
+        block_count = strs_count - block < decode->order_size
+            ? strs_count - block : decode->order_size;
+
+        /* count the lotteries - kept in valid until the slot is decoded */
+        memset(offsets, 0, sizeof(offsets));
+        for (i = 0; i < block_count; ++i) {
+            hashids_batch_lottery(hashids, decode,
+                strs + (block + i) * strs_stride, &lottery);
+            valid[block + i] = (unsigned char)lottery;
+            ++offsets[lottery];
+        }
+
+        /* bucket offsets, then the slots in lottery order */
+        for (i = 0, begin = 0; i < 256; ++i) {
+            end = begin + offsets[i];
+            offsets[i] = begin;
+            begin = end;
+        }
+        for (i = 0; i < block_count; ++i) {
+            decode->order[offsets[valid[block + i]]++] = (uint32_t)i;
+        }
+
+        /* offsets now end the buckets - 0xFF holds the ones without one */
+        for (lottery = 0, begin = 0; lottery < hashids->alphabet_length;
+            begin = offsets[lottery++]) {
+            if (offsets[lottery] > begin) {
+                result += hashids_batch_bucket(hashids, batch, decode,
+                    lottery, strs + block * strs_stride, strs_stride,
+                    decode->order + begin, offsets[lottery] - begin,
+                    numbers + block, valid + block);
+            }
+        }
+        for (i = offsets[0xFE]; i < offsets[0xFF]; ++i) {
+            numbers[block + decode->order[i]] = 0;
+            valid[block + decode->order[i]] = 0;
+        }
+    }
+
+    return result;
+}
+
+/* decode single-number hashes from fixed-size slots */
+size_t
+hashids_decode_one_batch(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid)
+{
+    struct hashids_batch_s batch;
+    struct hashids_batch_decode_s decode;
+    size_t result, order_size;
+    char *scratch;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* lottery buckets instead of every lottery's tables at once */
+    order_size = strs_count < HASHIDS_BATCH_BLOCK
+        ? strs_count : HASHIDS_BATCH_BLOCK;
+    scratch = (char *)hashids_instance_alloc(hashids,
+        hashids_batch_decode_size(hashids, order_size, 0));
+    if (HASHIDS_UNLIKELY(!scratch)) {
+        memset(numbers, 0, strs_count * sizeof(*numbers));
+        memset(valid, 0, strs_count);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return 0;
+    }
+    hashids_batch_decode_init(hashids, &decode, &batch, scratch, order_size,
+        0);
+
+    result = hashids_batch_decode(hashids, &batch, &decode, strs, strs_stride,
+        strs_count, numbers, valid);
+
+    hashids_instance_free(hashids, scratch);
+
+    return result;
+}
+
+/* slots per parallel task */
+#define HASHIDS_PARALLEL_CHUNK 1024u
+
+/* a worker's scratch - the instance itself is only read */
+struct hashids_parallel_worker_s {
+    struct hashids_batch_s batch;
+    struct hashids_batch_decode_s decode;
+    size_t valid_count;
+};
+
+/* a parallel call - tasks write straight into their own slots */
+struct hashids_parallel_s {
+    hashids_t *hashids;
+    char *buffer;
+    const char *strs;
+    size_t stride;
+    size_t count;
+    const unsigned long long *input;
+    unsigned long long *numbers;
+    unsigned char *valid;
+
+    struct hashids_parallel_worker_s *workers;
+};
+
+/* encode a chunk */
+static void
+hashids_parallel_encode(void *arg, size_t index, size_t worker)
+{
+    struct hashids_parallel_s *parallel;
+    size_t begin, count;
+
+    parallel = (struct hashids_parallel_s *)arg;
+    begin = index * HASHIDS_PARALLEL_CHUNK;
+    count = parallel->count - begin < HASHIDS_PARALLEL_CHUNK
+        ? parallel->count - begin : HASHIDS_PARALLEL_CHUNK;
+
+    hashids_batch_encode(parallel->hashids, &parallel->workers[worker].batch,
+        parallel->buffer + begin * parallel->stride, parallel->stride,
+        parallel->input + begin, count);
+}
+
+/* decode a chunk */
+static void
+hashids_parallel_decode(void *arg, size_t index, size_t worker)
+{
+    struct hashids_parallel_s *parallel;
+    struct hashids_parallel_worker_s *scratch;
+    size_t begin, count;
+
+    parallel = (struct hashids_parallel_s *)arg;
+    scratch = &parallel->workers[worker];
+    begin = index * HASHIDS_PARALLEL_CHUNK;
+    count = parallel->count - begin < HASHIDS_PARALLEL_CHUNK
+        ? parallel->count - begin : HASHIDS_PARALLEL_CHUNK;
+
+    scratch->valid_count += hashids_batch_decode(parallel->hashids,
+        &scratch->batch, &scratch->decode,
+        parallel->strs + begin * parallel->stride, parallel->stride, count,
+        parallel->numbers + begin, parallel->valid + begin);
+}
+
+/* run the chunks of a parallel call, on the calling thread without an
+   executor */
+static void
+hashids_parallel_run(const hashids_executor_t *executor,
+    void (*task)(void *arg, size_t index, size_t worker),
+    struct hashids_parallel_s *parallel)
+{
+    size_t i, tasks_count;
+
+    tasks_count = (parallel->count + HASHIDS_PARALLEL_CHUNK - 1)
+        / HASHIDS_PARALLEL_CHUNK;
+
+    if (!executor) {
+        for (i = 0; i < tasks_count; ++i) {
+            task(parallel, i, 0);
+        }
+    } else {
+        executor->run(executor->ctx, task, parallel, tasks_count);
+    }
+}
+
+/* encode single numbers into fixed-size slots, a chunk per task */
+size_t
+hashids_encode_one_parallel(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count, const hashids_executor_t *executor)
+{
+    struct hashids_parallel_s parallel;
+    unsigned long long largest = 0xFFFFFFFFFFFFFFFFull;
+    size_t i, workers_count, cache_size;
+    char *scratch;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (HASHIDS_UNLIKELY(buffer_stride
+        < hashids_estimate_encoded_size(hashids, 1, &largest))) {
+        return 0;
+    }
+
+    /* the workers, then their shuffled alphabets */
+    workers_count = executor ? executor->workers_count : 1;
+    cache_size = hashids->alphabet_length * (hashids->alphabet_length + 1);
+    scratch = (char *)hashids_instance_alloc(hashids, workers_count
+        * (sizeof(struct hashids_parallel_worker_s) + cache_size));
+    if (HASHIDS_UNLIKELY(!scratch)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return 0;
+    }
+
+    parallel.workers = (struct hashids_parallel_worker_s *)scratch;
+    scratch += workers_count * sizeof(struct hashids_parallel_worker_s);
+    for (i = 0; i < workers_count; ++i) {
+        hashids_batch_init(hashids, &parallel.workers[i].batch,
+            scratch + i * cache_size);
+    }
+
+    parallel.hashids = hashids;
+    parallel.buffer = buffer;
+    parallel.stride = buffer_stride;
+    parallel.count = numbers_count;
+    parallel.input = numbers;
+
+    hashids_parallel_run(executor, hashids_parallel_encode, &parallel);
+
+    hashids_instance_free(hashids, parallel.workers);
+
+    return numbers_count;
+}
+
+/* decode single-number hashes from fixed-size slots, a chunk per task */
+size_t
+hashids_decode_one_parallel(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid, const hashids_executor_t *executor)
+{
+    struct hashids_parallel_s parallel;
+    size_t i, result, workers_count, cache_size;
+    char *scratch;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* the workers, then their tables - kept for every lottery, as a worker
+       sees many chunks */
+    workers_count = executor ? executor->workers_count : 1;
+    cache_size = hashids_batch_decode_size(hashids, HASHIDS_PARALLEL_CHUNK, 1);
+    scratch = (char *)hashids_instance_alloc(hashids, workers_count
+        * (sizeof(struct hashids_parallel_worker_s) + cache_size));
+    if (HASHIDS_UNLIKELY(!scratch)) {
+        memset(numbers, 0, strs_count * sizeof(*numbers));
+        memset(valid, 0, strs_count);
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return 0;
+    }
+
+    parallel.workers = (struct hashids_parallel_worker_s *)scratch;
+    scratch += workers_count * sizeof(struct hashids_parallel_worker_s);
+    for (i = 0; i < workers_count; ++i) {
+        hashids_batch_decode_init(hashids, &parallel.workers[i].decode,
+            &parallel.workers[i].batch, scratch + i * cache_size,
+            HASHIDS_PARALLEL_CHUNK, 1);
+        parallel.workers[i].valid_count = 0;
+    }
+
+    parallel.hashids = hashids;
+    parallel.strs = strs;
+    parallel.stride = strs_stride;
+    parallel.count = strs_count;
+    parallel.numbers = numbers;
+    parallel.valid = valid;
+
+    hashids_parallel_run(executor, hashids_parallel_decode, &parallel);
+
+    for (i = 0, result = 0; i < workers_count; ++i) {
+        result += parallel.workers[i].valid_count;
+    }
+
+    hashids_instance_free(hashids, parallel.workers);
+
+    return result;
+}
+
+/* consecutive numbers encoder - one slot per lottery follows the struct */
+struct hashids_range_s {
+    hashids_t *hashids;
+    unsigned long long number;
+    unsigned long long numbers_hash;
+    int done;
+
+    /* digit values, least significant first - 64 at most for a 2-symbol
+       alphabet (plus one on wrap) */
+    unsigned char digits[HASHIDS_FANOUT_DIGITS + 1];
+    size_t digits_count;
+
+    char *cache;
+};
+
+/* start encoding consecutive numbers */
+hashids_range_t *
+hashids_range_init(hashids_t *hashids, unsigned long long start)
+{
+    hashids_range_t *result;
+    unsigned long long number;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* shuffled alphabets per lottery, filled on first use */
+    result = (hashids_range_t *)hashids_instance_alloc(hashids,
+        sizeof(hashids_range_t)
+        + hashids->alphabet_length * (hashids->alphabet_length + 1));
+    if (HASHIDS_UNLIKELY(!result)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    result->hashids = hashids;
+    result->number = start;
+    result->numbers_hash = start % 100;
+    result->cache = (char *)(result + 1);
+
+    number = start;
     do {
-        ch = number % 16;
-        if (ch > 9) {
-            ch += 'A' - 10;
-        } else {
-            ch += '0';
-        }
+        result->digits[result->digits_count++] =
+            (unsigned char)(number % hashids->alphabet_length);
+        number /= hashids->alphabet_length;
+    } while (number);
+
+    return result;
+}
+
+/* encode the current number and move to the next one */
+size_t
+hashids_range_next(hashids_range_t *range, char *buffer)
+{
+    hashids_t *hashids = range->hashids;
+    size_t i, lottery, result;
+    char *alphabet, *slot;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    /* past the largest number */
+    if (HASHIDS_UNLIKELY(range->done)) {
+        return 0;
+    }
+
+    /* return an estimation if no buffer */
+    if (HASHIDS_UNLIKELY(!buffer)) {
+        return hashids_estimate_encoded_size(hashids, 1, &range->number);
+    }
+
+    /* the shuffled alphabet of this lottery */
+    lottery = range->numbers_hash % hashids->alphabet_length;
+    buffer[0] = hashids->alphabet[lottery];
+    slot = range->cache + lottery * (hashids->alphabet_length + 1);
+    if (HASHIDS_UNLIKELY(!slot[hashids->alphabet_length])) {
+        hashids_lottery_alphabet(hashids, lottery, slot, alphabet_copy_2);
+        slot[hashids->alphabet_length] = 1;
+    }
+
+    /* padding shuffles the alphabet further */
+    alphabet = slot;
+    if (hashids->min_hash_length) {
+        memcpy(alphabet_copy_1, slot, hashids->alphabet_length);
+        alphabet = alphabet_copy_1;
+    }
+
+    for (i = 0; i < range->digits_count; ++i) {
+        buffer[1 + i] = (char)range->digits[range->digits_count - 1 - i];
+    }
+    result = hashids_encode_single(hashids, buffer, range->digits_count,
+        range->numbers_hash, alphabet, alphabet_copy_2);
+
+    /* odometer */
+    if (HASHIDS_UNLIKELY(++range->number == 0)) {
+        range->done = 1;
+    }
+    if (HASHIDS_UNLIKELY(++range->numbers_hash == 100)) {
+        range->numbers_hash = 0;
+    }
+    for (i = 0; i < range->digits_count
+        && ++range->digits[i] == hashids->alphabet_length; ++i) {
+        range->digits[i] = 0;
+    }
+    if (HASHIDS_UNLIKELY(i == range->digits_count)) {
+        range->digits[range->digits_count++] = 1;
+    }
+
+    return result;
+}
+
+/* "destructor" */
+void
+hashids_range_free(hashids_range_t *range)
+{
+    if (range) {
+        hashids_instance_free(range->hashids, range);
+    }
+}
+
+/* encoder for tuples sharing leading numbers - see hashids_encoder_init() */
+struct hashids_encoder_s {
+    hashids_t *hashids;
 
-        *temp++ = (char)ch;
+    unsigned long long *prefix;
+    size_t prefix_count;
+    unsigned long long prefix_hash;
+    size_t prefix_length;
 
-        number /= 16;
+    /* per lottery: the encoded prefix & the alphabet for the next number */
+    size_t *lengths;
+    unsigned char *ready;
+    char *alphabets;
+    char *outputs;
+};
+
+/* how many digits a number takes */
+static inline size_t
+hashids_digits_count(hashids_t *hashids, unsigned long long number)
+{
+    size_t result;
+
+    for (result = 1; number >= hashids->alphabet_length; ++result) {
+        number /= hashids->alphabet_length;
+    }
+
+    return result;
+}
+
+/* hash a number with an alphabet shuffled for it, returns the new end */
+static inline char *
+hashids_encode_number(hashids_t *hashids, char *buffer_end,
+    unsigned long long number, const char *alphabet, char *first)
+{
+    char *buffer_temp, temp_ch;
+    size_t j;
+
+    buffer_temp = buffer_end;
+    do {
+        *buffer_end++ = alphabet[number % hashids->alphabet_length];
+        number /= hashids->alphabet_length;
     } while (number);
 
-    temp--;
-    *temp = 0;
+    /* reverse the hash we got */
+    for (j = 0; j < (size_t)((buffer_end - buffer_temp) / 2); ++j) {
+        temp_ch = *(buffer_temp + j);
+        *(buffer_temp + j) = *(buffer_end - 1 - j);
+        *(buffer_end - 1 - j) = temp_ch;
+    }
+
+    *first = *buffer_temp;
+    return buffer_end;
+}
 
-    for (i = 0; i < (size_t)((temp - output) / 2); ++i) {
-        ch = *(output + i);
-        *(output + i) = *(temp - 1 - i);
-        *(temp - 1 - i) = ch;
+/* fill the cache of a lottery */
+static void
+hashids_encoder_fill(hashids_encoder_t *encoder, size_t lottery)
+{
+    hashids_t *hashids = encoder->hashids;
+    size_t i;
+    char ch, *output, *output_end;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+
+    /* the prefix, separators included, then the next number's shuffle */
+    output = output_end = encoder->outputs + lottery * encoder->prefix_length;
+    for (i = 0; i <= encoder->prefix_count; ++i) {
+        hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+            alphabet_copy_2);
+
+        if (i < encoder->prefix_count) {
+            output_end = hashids_encode_number(hashids, output_end,
+                encoder->prefix[i], alphabet_copy_1, &ch);
+            *output_end++ = hashids->separators[encoder->prefix[i]
+                % (ch + i) % hashids->separators_count];
+        }
     }
 
-    return 1;
+    memcpy(encoder->alphabets + lottery * hashids->alphabet_length,
+        alphabet_copy_1, hashids->alphabet_length);
+    encoder->lengths[lottery] = output_end - output;
+    encoder->ready[lottery] = 1;
+}
+
+/* "constructor" - the prefix is copied */
+hashids_encoder_t *
+hashids_encoder_init(hashids_t *hashids, size_t prefix_count,
+    unsigned long long *prefix)
+{
+    hashids_encoder_t *result;
+    size_t i, prefix_length;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* the longest the encoded prefix can get */
+    for (i = 0, prefix_length = 0; i < prefix_count; ++i) {
+        prefix_length += hashids_digits_count(hashids, prefix[i]) + 1;
+    }
+
+    /* a single block, the most aligned parts first */
+    result = (hashids_encoder_t *)hashids_instance_alloc(hashids,
+        sizeof(hashids_encoder_t)
+        + hashids->alphabet_length * sizeof(size_t)
+        + prefix_count * sizeof(unsigned long long)
+        + hashids->alphabet_length * (1 + hashids->alphabet_length
+            + prefix_length));
+    if (HASHIDS_UNLIKELY(!result)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    result->hashids = hashids;
+    result->lengths = (size_t *)(result + 1);
+    result->prefix = (unsigned long long *)(result->lengths
+        + hashids->alphabet_length);
+    result->ready = (unsigned char *)(result->prefix + prefix_count);
+    result->alphabets = (char *)(result->ready + hashids->alphabet_length);
+    result->outputs = result->alphabets
+        + hashids->alphabet_length * hashids->alphabet_length;
+
+    result->prefix_count = prefix_count;
+    result->prefix_length = prefix_length;
+    for (i = 0; i < prefix_count; ++i) {
+        result->prefix[i] = prefix[i];
+        result->prefix_hash += prefix[i] % (i + 100);
+    }
+
+    return result;
+}
+
+/* encode the prefix followed by the given numbers */
+size_t
+hashids_encoder_encode(hashids_encoder_t *encoder, char *buffer,
+    size_t numbers_count, unsigned long long *numbers)
+{
+    hashids_t *hashids = encoder->hashids;
+    size_t i, lottery, result_len;
+    unsigned long long numbers_hash;
+    char ch, *buffer_end;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    /* nothing to share */
+    if (HASHIDS_UNLIKELY(!numbers_count)) {
+        return hashids_encode(hashids, buffer, encoder->prefix_count,
+            encoder->prefix);
+    }
+
+    /* return an estimation if no buffer */
+    if (HASHIDS_UNLIKELY(!buffer)) {
+        for (i = 0, result_len = 1 + encoder->prefix_length;
+            i < numbers_count; ++i) {
+            result_len += hashids_estimate_number_size(hashids, numbers[i]);
+        }
+
+        return hashids_estimate_finish(hashids, numbers_count, result_len);
+    }
+
+    /* the lottery depends on all of the numbers */
+    for (i = 0, numbers_hash = encoder->prefix_hash; i < numbers_count; ++i) {
+        numbers_hash += numbers[i] % (encoder->prefix_count + i + 100);
+    }
+    lottery = numbers_hash % hashids->alphabet_length;
+    if (HASHIDS_UNLIKELY(!encoder->ready[lottery])) {
+        hashids_encoder_fill(encoder, lottery);
+    }
+
+    /* lottery & the cached prefix */
+    buffer[0] = hashids->alphabet[lottery];
+    memcpy(buffer + 1, encoder->outputs + lottery * encoder->prefix_length,
+        encoder->lengths[lottery]);
+    buffer_end = buffer + 1 + encoder->lengths[lottery];
+
+    /* continue from the cached alphabet */
+    memcpy(alphabet_copy_1,
+        encoder->alphabets + lottery * hashids->alphabet_length,
+        hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+
+    for (i = 0; i < numbers_count; ++i) {
+        if (i) {
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
+        }
+
+        buffer_end = hashids_encode_number(hashids, buffer_end, numbers[i],
+            alphabet_copy_1, &ch);
+
+        if (i + 1 < numbers_count) {
+            *buffer_end++ = hashids->separators[numbers[i]
+                % (ch + encoder->prefix_count + i)
+                % hashids->separators_count];
+        }
+    }
+
+    result_len = hashids_encode_pad(hashids, buffer, buffer_end - buffer,
+        numbers_hash, alphabet_copy_1, alphabet_copy_2);
+
+    buffer[result_len] = '\0';
+    return result_len;
+}
+
+/* "destructor" */
+void
+hashids_encoder_free(hashids_encoder_t *encoder)
+{
+    if (encoder) {
+        hashids_instance_free(encoder->hashids, encoder);
+    }
+}
+
+/* output of the streaming encoder is written a chunk at a time */
+#define HASHIDS_STREAM_CHUNK 4096u
+
+/* numbers read at once by the streaming encoder */
+#define HASHIDS_STREAM_NUMBERS 256u
+
+/* a number's digits & its separator - 64 digits in a 2-symbol alphabet */
+#define HASHIDS_STREAM_NUMBER_SIZE (HASHIDS_FANOUT_DIGITS + 1)
+
+/* encode numbers read in two passes, writing the hash out in chunks */
+size_t
+hashids_encode_stream(hashids_t *hashids,
+    const hashids_stream_source_t *source, const hashids_stream_sink_t *sink)
+{
+    unsigned long long numbers[HASHIDS_STREAM_NUMBERS], numbers_hash,
+        check_hash;
+    size_t i, count, index, numbers_count, lottery, used, flushed;
+    char ch, *buffer, *buffer_end;
+    char alphabet_copy_1[HASHIDS_MAX_ALPHABET_LENGTH + 1],
+        alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* pass one - the lottery depends on all of the numbers */
+    for (index = 0, numbers_hash = 0; (count = source->read(source->ctx,
+        index, numbers, HASHIDS_STREAM_NUMBERS)); index += count) {
+        for (i = 0; i < count; ++i) {
+            numbers_hash += numbers[i] % (index + i + 100);
+        }
+    }
+    numbers_count = index;
+
+    /* nothing to encode */
+    if (HASHIDS_UNLIKELY(!numbers_count)) {
+        return 0;
+    }
+
+    /* a chunk, or everything up to min_hash_length until padding is out */
+    buffer = (char *)hashids_instance_alloc(hashids, HASHIDS_STREAM_CHUNK
+        + hashids->min_hash_length + HASHIDS_STREAM_NUMBER_SIZE);
+    if (HASHIDS_UNLIKELY(!buffer)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return 0;
+    }
+
+    lottery = numbers_hash % hashids->alphabet_length;
+    buffer[0] = hashids->alphabet[lottery];
+    buffer_end = buffer + 1;
+    flushed = 0;
+
+    memcpy(alphabet_copy_1, hashids->alphabet, hashids->alphabet_length);
+    alphabet_copy_1[hashids->alphabet_length] = '\0';
+
+    /* pass two - the same numbers again */
+    for (index = 0, check_hash = 0; index < numbers_count; index += count) {
+        count = source->read(source->ctx, index, numbers,
+            HASHIDS_STREAM_NUMBERS);
+        if (HASHIDS_UNLIKELY(!count || count > numbers_count - index)) {
+            break;
+        }
+
+        for (i = 0; i < count; ++i) {
+            check_hash += numbers[i] % (index + i + 100);
+
+            hashids_shuffle_lottery(hashids, alphabet_copy_1, lottery,
+                alphabet_copy_2);
+            buffer_end = hashids_encode_number(hashids, buffer_end,
+                numbers[i], alphabet_copy_1, &ch);
+
+            if (index + i + 1 < numbers_count) {
+                *buffer_end++ = hashids->separators[numbers[i]
+                    % (ch + index + i) % hashids->separators_count];
+            }
+
+            /* padding only ever touches hashes shorter than min_hash_length */
+            used = buffer_end - buffer;
+            if (used >= HASHIDS_STREAM_CHUNK
+                && flushed + used >= hashids->min_hash_length) {
+                if (sink->write(sink->ctx, buffer, used)) {
+                    hashids_instance_free(hashids, buffer);
+                    hashids_errno = HASHIDS_ERROR_IO;
+                    return 0;
+                }
+                flushed += used;
+                buffer_end = buffer;
+            }
+        }
+    }
+
+    /* the source changed between the passes */
+    if (HASHIDS_UNLIKELY(index != numbers_count
+        || check_hash != numbers_hash)) {
+        hashids_instance_free(hashids, buffer);
+        hashids_errno = HASHIDS_ERROR_INVALID_NUMBER;
+        return 0;
+    }
+
+    used = buffer_end - buffer;
+    if (!flushed) {
+        used = hashids_encode_pad(hashids, buffer, used, numbers_hash,
+            alphabet_copy_1, alphabet_copy_2);
+    }
+    if (used && sink->write(sink->ctx, buffer, used)) {
+        hashids_instance_free(hashids, buffer);
+        hashids_errno = HASHIDS_ERROR_IO;
+        return 0;
+    }
+
+    hashids_instance_free(hashids, buffer);
+    return flushed + used;
+}
+
+/* stream decoder states */
+#define HASHIDS_DECODER_PADDING 0
+#define HASHIDS_DECODER_LOTTERY 1
+#define HASHIDS_DECODER_NUMBERS 2
+#define HASHIDS_DECODER_GUARDED 3
+#define HASHIDS_DECODER_FAILED 4
+
+/* resumable decoder - the padding lookahead (min_hash_length characters)
+   follows the struct */
+struct hashids_stream_decoder_s {
+    hashids_t *hashids;
+    hashids_number_sink_t sink;
+
+    int state;
+    int error;
+    size_t lottery;
+    unsigned long long number;
+    size_t numbers_count;
+    char alphabet[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    char *pending;
+    size_t pending_length;
+};
+
+/* start over */
+static void
+hashids_stream_decoder_reset(hashids_stream_decoder_t *decoder)
+{
+    decoder->state = decoder->hashids->min_hash_length
+        ? HASHIDS_DECODER_PADDING : HASHIDS_DECODER_LOTTERY;
+    decoder->error = HASHIDS_ERROR_OK;
+    decoder->number = 0;
+    decoder->numbers_count = 0;
+    decoder->pending_length = 0;
+}
+
+/* fail for good - until the next hashids_stream_decoder_finish() */
+static int
+hashids_stream_decoder_fail(hashids_stream_decoder_t *decoder, int error)
+{
+    decoder->state = HASHIDS_DECODER_FAILED;
+    decoder->error = error;
+    hashids_errno = error;
+
+    return error;
+}
+
+/* one character past the padding - hashids_decode(), a step at a time */
+static inline int
+hashids_stream_decoder_step(hashids_stream_decoder_t *decoder, char ch)
+{
+    hashids_t *hashids = decoder->hashids;
+    char *c, alphabet_copy_2[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+
+    switch (decoder->state) {
+        case HASHIDS_DECODER_LOTTERY:
+            /* hashids_encode() takes it from the alphabet */
+            if (!(c = strchr(hashids->alphabet, ch))) {
+                return hashids_stream_decoder_fail(decoder,
+                    HASHIDS_ERROR_INVALID_HASH);
+            }
+            decoder->lottery = c - hashids->alphabet;
+
+            /* scratch alphabet for this lottery, first shuffle */
+            memcpy(decoder->alphabet, hashids->alphabet,
+                hashids->alphabet_length);
+            decoder->alphabet[hashids->alphabet_length] = '\0';
+            hashids_shuffle_lottery(hashids, decoder->alphabet,
+                decoder->lottery, alphabet_copy_2);
+
+            decoder->state = HASHIDS_DECODER_NUMBERS;
+            return HASHIDS_ERROR_OK;
+
+        case HASHIDS_DECODER_NUMBERS:
+            if (strchr(hashids->guards, ch)) {
+                decoder->state = HASHIDS_DECODER_GUARDED;
+                return HASHIDS_ERROR_OK;
+            }
+            if (strchr(hashids->separators, ch)) {
+                /* hand the number out */
+                if (decoder->sink.emit(decoder->sink.ctx, decoder->number)) {
+                    return hashids_stream_decoder_fail(decoder,
+                        HASHIDS_ERROR_IO);
+                }
+                ++decoder->numbers_count;
+                decoder->number = 0;
+
+                /* resalt the alphabet */
+                hashids_shuffle_lottery(hashids, decoder->alphabet,
+                    decoder->lottery, alphabet_copy_2);
+                return HASHIDS_ERROR_OK;
+            }
+            if (!(c = strchr(decoder->alphabet, ch))) {
+                return hashids_stream_decoder_fail(decoder,
+                    HASHIDS_ERROR_INVALID_HASH);
+            }
+
+            decoder->number *= hashids->alphabet_length;
+            decoder->number += c - decoder->alphabet;
+            return HASHIDS_ERROR_OK;
+
+        default:
+            /* everything after the closing guard is ignored */
+            return HASHIDS_ERROR_OK;
+    }
+}
+
+/* no guard within the first min_hash_length characters - not padded */
+static int
+hashids_stream_decoder_replay(hashids_stream_decoder_t *decoder)
+{
+    size_t i;
+    int result = HASHIDS_ERROR_OK;
+
+    decoder->state = HASHIDS_DECODER_LOTTERY;
+    for (i = 0; i < decoder->pending_length && !result; ++i) {
+        result = hashids_stream_decoder_step(decoder, decoder->pending[i]);
+    }
+    decoder->pending_length = 0;
+
+    return result;
+}
+
+/* "constructor" */
+hashids_stream_decoder_t *
+hashids_stream_decoder_init(hashids_t *hashids,
+    const hashids_number_sink_t *sink)
+{
+    hashids_stream_decoder_t *result;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    result = (hashids_stream_decoder_t *)hashids_instance_alloc(hashids,
+        sizeof(hashids_stream_decoder_t) + hashids->min_hash_length);
+    if (HASHIDS_UNLIKELY(!result)) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    result->hashids = hashids;
+    result->sink = *sink;
+    result->pending = (char *)(result + 1);
+    hashids_stream_decoder_reset(result);
+
+    return result;
+}
+
+/* decode the next fragment of a hash */
+int
+hashids_stream_decoder_feed(hashids_stream_decoder_t *decoder,
+    const char *data, size_t length)
+{
+    hashids_t *hashids = decoder->hashids;
+    size_t i;
+    int result;
+    char ch;
+
+    for (i = 0; i < length; ++i) {
+        ch = data[i];
+
+        if (HASHIDS_UNLIKELY(decoder->state == HASHIDS_DECODER_FAILED)) {
+            hashids_errno = decoder->error;
+            return decoder->error;
+        }
+        if (HASHIDS_UNLIKELY(!ch)) {
+            return hashids_stream_decoder_fail(decoder,
+                HASHIDS_ERROR_INVALID_HASH);
+        }
+
+        /* skip characters up to the first guard, if there is one that soon */
+        if (decoder->state == HASHIDS_DECODER_PADDING) {
+            if (strchr(hashids->guards, ch)) {
+                decoder->pending_length = 0;
+                decoder->state = HASHIDS_DECODER_LOTTERY;
+                continue;
+            }
+
+            decoder->pending[decoder->pending_length++] = ch;
+            if (decoder->pending_length == hashids->min_hash_length
+                && (result = hashids_stream_decoder_replay(decoder))) {
+                return result;
+            }
+            continue;
+        }
+
+        if ((result = hashids_stream_decoder_step(decoder, ch))) {
+            return result;
+        }
+    }
+
+    return HASHIDS_ERROR_OK;
+}
+
+/* hand out the last number & start over - returns the numbers count */
+size_t
+hashids_stream_decoder_finish(hashids_stream_decoder_t *decoder)
+{
+    size_t result = 0;
+    int error = HASHIDS_ERROR_OK;
+
+    /* a short hash without guards */
+    if (decoder->state == HASHIDS_DECODER_PADDING) {
+        error = hashids_stream_decoder_replay(decoder);
+    }
+
+    switch (decoder->state) {
+        case HASHIDS_DECODER_FAILED:
+            error = decoder->error;
+            break;
+        case HASHIDS_DECODER_LOTTERY:
+            error = HASHIDS_ERROR_INVALID_HASH;
+            break;
+        default:
+            if (decoder->sink.emit(decoder->sink.ctx, decoder->number)) {
+                error = HASHIDS_ERROR_IO;
+                break;
+            }
+            result = decoder->numbers_count + 1;
+            break;
+    }
+
+    hashids_stream_decoder_reset(decoder);
+    if (error) {
+        hashids_errno = error;
+    }
+
+    return result;
+}
+
+/* "destructor" */
+void
+hashids_stream_decoder_free(hashids_stream_decoder_t *decoder)
+{
+    if (decoder) {
+        hashids_instance_free(decoder->hashids, decoder);
+    }
 }
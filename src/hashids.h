@@ -3,15 +3,22 @@
 
 #include <stdlib.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* version constants */
-#define HASHIDS_VERSION "1.2.1"
-#define HASHIDS_VERSION_MAJOR 1
-#define HASHIDS_VERSION_MINOR 2
-#define HASHIDS_VERSION_PATCH 1
+#define HASHIDS_VERSION "2.0.0"
+#define HASHIDS_VERSION_MAJOR 2
+#define HASHIDS_VERSION_MINOR 0
+#define HASHIDS_VERSION_PATCH 0
 
 /* minimal alphabet length */
 #define HASHIDS_MIN_ALPHABET_LENGTH 16u
 
+/* maximal alphabet length (unique non-NUL bytes) */
+#define HASHIDS_MAX_ALPHABET_LENGTH 255u
+
 /* separator divisor */
 #define HASHIDS_SEPARATOR_DIVISOR 3.5f
 
@@ -32,6 +39,17 @@
 /* default separators */
 #define HASHIDS_DEFAULT_SEPARATORS "cfhistuCFHISTU"
 
+/* binary UUID size */
+#define HASHIDS_UUID_SIZE 16u
+
+/* hashids_encode_uuid() buffer size, unless min_hash_length is longer - the
+   lottery, 128 digits of a 2-symbol alphabet & the NUL */
+#define HASHIDS_UUID_BUFFER_SIZE 130u
+
+/* tables hashids_init5() can precompute */
+#define HASHIDS_TABLE_SHUFFLE 1u
+#define HASHIDS_TABLE_PAD 2u
+
 /* error codes */
 #define HASHIDS_ERROR_OK                0
 #define HASHIDS_ERROR_ALLOC             -1
@@ -39,6 +57,10 @@
 #define HASHIDS_ERROR_ALPHABET_SPACE    -3
 #define HASHIDS_ERROR_INVALID_HASH      -4
 #define HASHIDS_ERROR_INVALID_NUMBER    -5
+#define HASHIDS_ERROR_IO                -6
+#define HASHIDS_ERROR_INVALID_FILE      -7
+#define HASHIDS_ERROR_LIMIT             -8
+#define HASHIDS_ERROR_NEED_SPACE        -9
 
 /* thread-safe hashids_errno indirection */
 extern int *__hashids_errno_addr(void);
@@ -48,11 +70,30 @@ extern int *__hashids_errno_addr(void);
 extern void *(*_hashids_alloc)(size_t size);
 extern void (*_hashids_free)(void *ptr);
 
+/* per-instance allocator context */
+struct hashids_allocator_s {
+    void *(*alloc)(void *ctx, size_t size);
+    void (*free)(void *ctx, void *ptr);
+    void *ctx;
+};
+typedef struct hashids_allocator_s hashids_allocator_t;
+
+/* the default context - defers to _hashids_alloc & _hashids_free */
+extern const hashids_allocator_t hashids_default_allocator;
+
+/* bump arena - everything is released at once by hashids_arena_reset() */
+struct hashids_arena_s {
+    hashids_allocator_t allocator;
+    char *buffer;
+    size_t size;
+    size_t used;
+    size_t last;
+};
+typedef struct hashids_arena_s hashids_arena_t;
+
 /* the hashids "object" */
 struct hashids_s {
     char *alphabet;
-    char *alphabet_copy_1;
-    char *alphabet_copy_2;
     size_t alphabet_length;
 
     char *salt;
@@ -65,16 +106,150 @@ struct hashids_s {
     size_t guards_count;
 
     size_t min_hash_length;
+
+    /* tables asked for at init (HASHIDS_TABLE_*) */
+    unsigned int tables;
+
+    /* shuffle steps fixed by lottery & salt, a row per alphabet character
+       (NULL without HASHIDS_TABLE_SHUFFLE) */
+    unsigned char *shuffle_steps;
+    size_t shuffle_steps_count;
+    size_t shuffle_sum;
+
+    /* pad characters of single numbers, by lottery & digits count (NULL
+       without HASHIDS_TABLE_PAD) */
+    unsigned char *pad_templates;
+    size_t pad_digits_count;
+
+    /* single block backing all of the strings & tables above */
+    char *storage;
+    size_t storage_size;
+
+    /* salt-independent alphabet followed by separators (hashids_derive) */
+    char *prepared;
+    size_t prepared_alphabet_length;
+    size_t prepared_separators_count;
+
+    hashids_allocator_t allocator;
 };
 typedef struct hashids_s hashids_t;
 
+/* encoder for consecutive numbers */
+typedef struct hashids_range_s hashids_range_t;
+
+/* encoder for tuples sharing leading numbers */
+typedef struct hashids_encoder_s hashids_encoder_t;
+
+/* numbers into hashids_encode_stream() - read() copies up to numbers_max
+   numbers starting at index and returns how many, 0 past the last one */
+struct hashids_stream_source_s {
+    size_t (*read)(void *ctx, size_t index, unsigned long long *numbers,
+        size_t numbers_max);
+    void *ctx;
+};
+typedef struct hashids_stream_source_s hashids_stream_source_t;
+
+/* characters out of hashids_encode_stream() - non-zero from write() aborts */
+struct hashids_stream_sink_s {
+    int (*write)(void *ctx, const char *data, size_t length);
+    void *ctx;
+};
+typedef struct hashids_stream_sink_s hashids_stream_sink_t;
+
+/* numbers out of a stream decoder - non-zero from emit() aborts */
+struct hashids_number_sink_s {
+    int (*emit)(void *ctx, unsigned long long number);
+    void *ctx;
+};
+typedef struct hashids_number_sink_s hashids_number_sink_t;
+
+/* resumable decoder over hash fragments */
+typedef struct hashids_stream_decoder_s hashids_stream_decoder_t;
+
+/* registry of shared instances keyed by (salt, alphabet, min_hash_length) */
+typedef struct hashids_registry_s hashids_registry_t;
+
+/* a registry entry - read-only, the key lives right after the structure */
+struct hashids_registry_entry_s {
+    hashids_t *hashids;
+
+    struct hashids_registry_entry_s *chain;
+    struct hashids_registry_entry_s *lru_prev;
+    struct hashids_registry_entry_s *lru_next;
+
+    unsigned long long hash;
+    size_t refs;
+
+    size_t min_hash_length;
+    size_t salt_length;
+    size_t alphabet_length;
+    char key[1];
+};
+typedef struct hashids_registry_entry_s hashids_registry_entry_t;
+
+/* a read-only mapped file of prepared instances */
+typedef struct hashids_file_s hashids_file_t;
+
+/* runs task(arg, index, worker) for every index below tasks_count, returning
+   once all of them have - worker is below workers_count, and no two tasks run
+   with the same worker at the same time */
+struct hashids_executor_s {
+    void (*run)(void *ctx, void (*task)(void *arg, size_t index,
+        size_t worker), void *arg, size_t tasks_count);
+    void *ctx;
+    size_t workers_count;
+};
+typedef struct hashids_executor_s hashids_executor_t;
+
+/* work-stealing thread pool, usable as an executor */
+typedef struct hashids_pool_s hashids_pool_t;
+
+/* memo of tuples to hashes & hashes to tuples over an instance */
+typedef struct hashids_memo_s hashids_memo_t;
+
+/* memo counters - hits & misses per direction, batch inputs served from an
+   earlier slot of the same batch */
+struct hashids_memo_stats_s {
+    unsigned long long encode_hits;
+    unsigned long long encode_misses;
+    unsigned long long decode_hits;
+    unsigned long long decode_misses;
+    unsigned long long evictions;
+    unsigned long long duplicates;
+};
+typedef struct hashids_memo_stats_s hashids_memo_stats_t;
+
+/* decoder over several configurations, e.g. during a salt rotation */
+typedef struct hashids_multi_s hashids_multi_t;
+
+/* a read-only mapped file of every hash below a count */
+typedef struct hashids_dict_s hashids_dict_t;
+
 /* exported function definitions */
+void
+hashids_arena_init(hashids_arena_t *arena, void *buffer, size_t size);
+
+void
+hashids_arena_reset(hashids_arena_t *arena);
+
 void
 hashids_shuffle(char *str, size_t str_length, char *salt, size_t salt_length);
 
 void
 hashids_free(hashids_t *hashids);
 
+hashids_t *
+hashids_init5(const char *salt, size_t min_hash_length,
+    const char *alphabet, const hashids_allocator_t *allocator,
+    unsigned int tables);
+
+hashids_t *
+hashids_init4(const char *salt, size_t min_hash_length,
+    const char *alphabet, const hashids_allocator_t *allocator);
+
+hashids_t *
+hashids_derive(const hashids_t *hashids, const char *salt);
+
 hashids_t *
 hashids_init3(const char *salt, size_t min_hash_length,
     const char *alphabet);
@@ -103,6 +278,11 @@ size_t
 hashids_encode_one(hashids_t *hashids, char *buffer,
     unsigned long long number);
 
+size_t
+hashids_encode_fanout(hashids_t **instances, size_t instances_count,
+    char *buffer, size_t buffer_stride, size_t numbers_count,
+    unsigned long long *numbers);
+
 size_t
 hashids_numbers_count(hashids_t *hashids, const char *str);
 
@@ -118,10 +298,206 @@ size_t
 hashids_decode_safe(hashids_t *hashids, const char *str,
     unsigned long long *numbers, size_t numbers_max);
 
+size_t
+hashids_decode_bounded(hashids_t *hashids, const char *str,
+    unsigned long long *numbers, size_t numbers_max, size_t max_length);
+
+size_t
+hashids_decode_into(hashids_t *hashids, const char *str,
+    unsigned long long *numbers, size_t numbers_max);
+
 size_t
 hashids_encode_hex(hashids_t *hashids, char *buffer, const char *hex_str);
 
 size_t
 hashids_decode_hex(hashids_t *hashids, char *str, char *output);
 
+size_t
+hashids_encode_hex_big(hashids_t *hashids, char *buffer, const char *hex_str);
+
+size_t
+hashids_decode_hex_big(hashids_t *hashids, const char *str, char *output,
+    size_t output_size);
+
+size_t
+hashids_encode_bytes(hashids_t *hashids, char *buffer,
+    const unsigned char *bytes, size_t bytes_count);
+
+size_t
+hashids_decode_bytes(hashids_t *hashids, const char *str,
+    unsigned char *bytes, size_t bytes_max);
+
+size_t
+hashids_encode_uuid(hashids_t *hashids, char *buffer,
+    const unsigned char *uuid);
+
+size_t
+hashids_decode_uuid(hashids_t *hashids, const char *str,
+    unsigned char *uuid);
+
+size_t
+hashids_encode_uuid_batch(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned char *uuids, size_t uuids_count);
+
+size_t
+hashids_decode_uuid_batch(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned char *uuids);
+
+size_t
+hashids_encode_one_batch(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count);
+
+size_t
+hashids_decode_one_batch(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid);
+
+size_t
+hashids_encode_one_parallel(hashids_t *hashids, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count, const hashids_executor_t *executor);
+
+size_t
+hashids_decode_one_parallel(hashids_t *hashids, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid, const hashids_executor_t *executor);
+
+hashids_range_t *
+hashids_range_init(hashids_t *hashids, unsigned long long start);
+
+size_t
+hashids_range_next(hashids_range_t *range, char *buffer);
+
+void
+hashids_range_free(hashids_range_t *range);
+
+hashids_encoder_t *
+hashids_encoder_init(hashids_t *hashids, size_t prefix_count,
+    unsigned long long *prefix);
+
+size_t
+hashids_encoder_encode(hashids_encoder_t *encoder, char *buffer,
+    size_t numbers_count, unsigned long long *numbers);
+
+void
+hashids_encoder_free(hashids_encoder_t *encoder);
+
+size_t
+hashids_encode_stream(hashids_t *hashids,
+    const hashids_stream_source_t *source, const hashids_stream_sink_t *sink);
+
+hashids_stream_decoder_t *
+hashids_stream_decoder_init(hashids_t *hashids,
+    const hashids_number_sink_t *sink);
+
+int
+hashids_stream_decoder_feed(hashids_stream_decoder_t *decoder,
+    const char *data, size_t length);
+
+size_t
+hashids_stream_decoder_finish(hashids_stream_decoder_t *decoder);
+
+void
+hashids_stream_decoder_free(hashids_stream_decoder_t *decoder);
+
+hashids_registry_t *
+hashids_registry_init(size_t capacity);
+
+void
+hashids_registry_free(hashids_registry_t *registry);
+
+hashids_registry_entry_t *
+hashids_registry_acquire(hashids_registry_t *registry, const char *salt,
+    size_t min_hash_length, const char *alphabet);
+
+void
+hashids_registry_release(hashids_registry_entry_t *entry);
+
+int
+hashids_file_save(const char *path, hashids_t **instances, size_t count);
+
+hashids_file_t *
+hashids_file_open(const char *path);
+
+void
+hashids_file_close(hashids_file_t *file);
+
+size_t
+hashids_file_count(const hashids_file_t *file);
+
+hashids_t *
+hashids_file_get(hashids_file_t *file, size_t index);
+
+hashids_pool_t *
+hashids_pool_init(size_t threads_count);
+
+void
+hashids_pool_free(hashids_pool_t *pool);
+
+const hashids_executor_t *
+hashids_pool_executor(hashids_pool_t *pool);
+
+hashids_memo_t *
+hashids_memo_init(hashids_t *hashids, size_t capacity);
+
+void
+hashids_memo_free(hashids_memo_t *memo);
+
+size_t
+hashids_memo_encode(hashids_memo_t *memo, char *buffer, size_t numbers_count,
+    unsigned long long *numbers);
+
+size_t
+hashids_memo_decode(hashids_memo_t *memo, const char *str,
+    unsigned long long *numbers, size_t numbers_max);
+
+size_t
+hashids_memo_encode_one_batch(hashids_memo_t *memo, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count);
+
+size_t
+hashids_memo_decode_one_batch(hashids_memo_t *memo, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid);
+
+void
+hashids_memo_stats(hashids_memo_t *memo, hashids_memo_stats_t *stats);
+
+hashids_multi_t *
+hashids_multi_init(hashids_t **instances, size_t count);
+
+void
+hashids_multi_free(hashids_multi_t *multi);
+
+size_t
+hashids_multi_decode(hashids_multi_t *multi, const char *str,
+    unsigned long long *numbers, size_t numbers_max, size_t *index);
+
+int
+hashids_dict_save(const char *path, hashids_t *hashids,
+    unsigned long long count);
+
+hashids_dict_t *
+hashids_dict_open(const char *path);
+
+void
+hashids_dict_close(hashids_dict_t *dict);
+
+unsigned long long
+hashids_dict_count(const hashids_dict_t *dict);
+
+size_t
+hashids_dict_encode(const hashids_dict_t *dict, char *buffer,
+    unsigned long long number);
+
+size_t
+hashids_dict_decode(const hashids_dict_t *dict, const char *str,
+    unsigned long long *number);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
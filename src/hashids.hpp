@@ -0,0 +1,667 @@
+#ifndef HASHIDS_HPP
+#define HASHIDS_HPP 1
+
+#if __cplusplus < 201703L
+#error "hashids.hpp needs C++17"
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include "hashids.h"
+
+/*
+ * Compile-time specialized codec. Everything hashids_init5() works out from
+ * the salt, the alphabet & min_hash_length with all of its tables -
+ * separators, guards, the shuffled alphabet, the first per-number shuffle of
+ * every lottery & the padding templates - is a constant of the
+ * instantiation, and every division is by a literal. The output is the same
+ * as hashids_encode() of an instance with the same configuration.
+ *
+ *     static constexpr char salt[] = "this is my salt";
+ *     using ids = hashids::codec<salt, 8>;
+ *
+ *     char buffer[ids::max_encoded_size(1)];
+ *     ids::encode_one(buffer, 12345);
+ */
+namespace hashids {
+
+/* HASHIDS_DEFAULT_ALPHABET, usable as a template argument */
+inline constexpr char default_alphabet[] = HASHIDS_DEFAULT_ALPHABET;
+
+namespace detail {
+
+using std::size_t;
+
+/* padding templates cover single numbers up to this min_hash_length */
+inline constexpr size_t pad_template_max = 32;
+
+/* not a character of the lottery / first-number tables */
+inline constexpr unsigned char none = 0xFF;
+
+/* strlen() */
+constexpr size_t
+length(const char *str)
+{
+    size_t result = 0;
+
+    while (str[result]) {
+        ++result;
+    }
+
+    return result;
+}
+
+/* hashids_shuffle() */
+constexpr void
+shuffle(char *str, size_t str_length, const char *salt, size_t salt_length)
+{
+    size_t i = 0, j = 0, v = 0, p = 0;
+    char temp = 0;
+
+    if (!salt_length) {
+        return;
+    }
+
+    for (i = str_length - 1; i > 0; --i, ++v) {
+        if (v == salt_length) {
+            v = 0;
+        }
+        p += salt[v];
+        j = (salt[v] + v + p) % i;
+        temp = str[i]; str[i] = str[j]; str[j] = temp;
+    }
+}
+
+/* the per-number shuffle - salted by lottery + salt + the alphabet as it
+   was, alphabet_length characters of it */
+constexpr void
+shuffle_lottery(char *alphabet, size_t alphabet_length, char lottery,
+    const char *salt, size_t salt_length, char *scratch)
+{
+    size_t i = 0, j = 1;
+
+    scratch[0] = lottery;
+    for (i = 0; i < salt_length && j < alphabet_length; ++i) {
+        scratch[j++] = salt[i];
+    }
+    for (i = 0; j < alphabet_length; ++i) {
+        scratch[j++] = alphabet[i];
+    }
+
+    shuffle(alphabet, alphabet_length, scratch, alphabet_length);
+}
+
+/* hashids_pad_step() */
+constexpr size_t
+pad_step(char *buffer, size_t result_len, size_t min_hash_length,
+    const char *alphabet, size_t alphabet_length)
+{
+    size_t i = (min_hash_length - result_len + 1) / 2,
+        j = (min_hash_length - result_len) / 2, k = 0;
+
+    if (i > (alphabet_length + 1) / 2) {
+        i = (alphabet_length + 1) / 2;
+    }
+    if (j > alphabet_length / 2) {
+        j = alphabet_length / 2;
+    }
+    if ((i + j) % 2 == 0 && alphabet_length % 2 == 1) {
+        ++i; --j;
+    }
+
+    for (k = result_len; k > 0; --k) {
+        buffer[i + k - 1] = buffer[k - 1];
+    }
+    for (k = 0; k < i; ++k) {
+        buffer[k] = alphabet[alphabet_length - i + k];
+    }
+    for (k = 0; k < j; ++k) {
+        buffer[i + result_len + k] = alphabet[k];
+    }
+
+    return result_len + i + j;
+}
+
+/* what hashids_init3() works out from the salt & the alphabet */
+struct tables {
+    char alphabet[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+    size_t alphabet_length;
+
+    char separators[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+    size_t separators_count;
+
+    char guards[HASHIDS_MAX_ALPHABET_LENGTH + 1];
+    size_t guards_count;
+
+    int error;
+};
+
+/* hashids_prepare() & hashids_setup() */
+constexpr tables
+make_tables(const char *salt, const char *alphabet)
+{
+    tables result{};
+    bool seen[256]{}, separator[256]{};
+    char unique[HASHIDS_MAX_ALPHABET_LENGTH + 1]{};
+    const char defaults[] = HASHIDS_DEFAULT_SEPARATORS;
+    size_t i = 0, len = 0, count = 0, salt_length = length(salt);
+
+    /* extract only the unique characters */
+    for (i = 0; alphabet[i]; ++i) {
+        if (!seen[(unsigned char)alphabet[i]]) {
+            seen[(unsigned char)alphabet[i]] = true;
+            unique[len++] = alphabet[i];
+        }
+    }
+
+    /* check length and whitespace */
+    if (len < HASHIDS_MIN_ALPHABET_LENGTH) {
+        result.error = HASHIDS_ERROR_ALPHABET_LENGTH;
+        return result;
+    }
+    if (seen[0x20] || seen[0x09]) {
+        result.error = HASHIDS_ERROR_ALPHABET_SPACE;
+        return result;
+    }
+
+    /* take default separators out, in the order of
+       HASHIDS_DEFAULT_SEPARATORS */
+    for (i = 0; defaults[i]; ++i) {
+        separator[(unsigned char)defaults[i]] = true;
+    }
+    for (i = 0; i < len; ++i) {
+        if (!separator[(unsigned char)unique[i]]) {
+            result.alphabet[result.alphabet_length++] = unique[i];
+        }
+    }
+    for (i = 0; defaults[i]; ++i) {
+        if (seen[(unsigned char)defaults[i]]) {
+            result.separators[result.separators_count++] = defaults[i];
+        }
+    }
+
+    /* shuffle the separators */
+    if (result.separators_count) {
+        shuffle(result.separators, result.separators_count, salt,
+            salt_length);
+    }
+
+    /* check if we have any/enough separators - alphabet / separators is
+       above HASHIDS_SEPARATOR_DIVISOR (3.5) */
+    if (!result.separators_count
+        || 2 * result.alphabet_length > 7 * result.separators_count) {
+        count = (2 * result.alphabet_length + 6) / 7;
+
+        if (count == 1) {
+            count = 2;
+        }
+
+        if (count > result.separators_count) {
+            /* we need more separators - get some from alphabet */
+            len = count - result.separators_count;
+            for (i = 0; i < len; ++i) {
+                result.separators[result.separators_count++] =
+                    result.alphabet[i];
+            }
+            for (i = len; i < result.alphabet_length; ++i) {
+                result.alphabet[i - len] = result.alphabet[i];
+            }
+            result.alphabet_length -= len;
+            result.alphabet[result.alphabet_length] = '\0';
+        } else {
+            /* we have more than enough - truncate */
+            result.separators_count = count;
+            result.separators[count] = '\0';
+        }
+    }
+
+    /* shuffle alphabet */
+    shuffle(result.alphabet, result.alphabet_length, salt, salt_length);
+
+    /* guards - from the separators if the alphabet is tiny */
+    result.guards_count = (result.alphabet_length + HASHIDS_GUARD_DIVISOR - 1)
+        / HASHIDS_GUARD_DIVISOR;
+    if (result.alphabet_length < 3) {
+        for (i = 0; i < result.guards_count; ++i) {
+            result.guards[i] = result.separators[i];
+        }
+        for (i = result.guards_count; i < result.separators_count; ++i) {
+            result.separators[i - result.guards_count] = result.separators[i];
+        }
+        result.separators_count -= result.guards_count;
+        result.separators[result.separators_count] = '\0';
+    } else {
+        for (i = 0; i < result.guards_count; ++i) {
+            result.guards[i] = result.alphabet[i];
+        }
+        for (i = result.guards_count; i < result.alphabet_length; ++i) {
+            result.alphabet[i - result.guards_count] = result.alphabet[i];
+        }
+        result.alphabet_length -= result.guards_count;
+        result.alphabet[result.alphabet_length] = '\0';
+    }
+
+    return result;
+}
+
+/* the alphabet of the first number of every lottery, & its inverse */
+template <size_t N>
+struct lotteries {
+    char alphabets[N][N];
+    unsigned char values[N][256];
+};
+
+template <size_t N>
+constexpr lotteries<N>
+make_lotteries(const tables &t, const char *salt)
+{
+    lotteries<N> result{};
+    char scratch[N]{};
+    size_t lottery = 0, i = 0, salt_length = length(salt);
+
+    for (lottery = 0; lottery < N; ++lottery) {
+        for (i = 0; i < N; ++i) {
+            result.alphabets[lottery][i] = t.alphabet[i];
+        }
+        shuffle_lottery(result.alphabets[lottery], N, t.alphabet[lottery],
+            salt, salt_length, scratch);
+
+        for (i = 0; i < 256; ++i) {
+            result.values[lottery][i] = none;
+        }
+        for (i = 0; i < N; ++i) {
+            result.values[lottery][(unsigned char)
+                result.alphabets[lottery][i]] = (unsigned char)i;
+        }
+    }
+
+    return result;
+}
+
+/* character classes: the lottery position of alphabet characters,
+   separators & guards */
+struct classes {
+    unsigned char lottery[256];
+    bool separator[256];
+    bool guard[256];
+};
+
+constexpr classes
+make_classes(const tables &t)
+{
+    classes result{};
+    size_t i = 0;
+
+    for (i = 0; i < 256; ++i) {
+        result.lottery[i] = none;
+    }
+    for (i = 0; i < t.alphabet_length; ++i) {
+        result.lottery[(unsigned char)t.alphabet[i]] = (unsigned char)i;
+    }
+    for (i = 0; i < t.separators_count; ++i) {
+        result.separator[(unsigned char)t.separators[i]] = true;
+    }
+    for (i = 0; i < t.guards_count; ++i) {
+        result.guard[(unsigned char)t.guards[i]] = true;
+    }
+
+    return result;
+}
+
+/* padding templates - as hashids_pad_setup(), but a whole min_hash_length
+   row per lottery & digits count, the guards & the hash left as NULs */
+template <size_t N, size_t D, size_t M>
+struct pads {
+    unsigned char left[N][D];
+    char rows[N][D][M];
+};
+
+template <size_t N, size_t D, size_t M>
+constexpr pads<N, D, M>
+make_pads(const lotteries<N> &l)
+{
+    pads<N, D, M> result{};
+    char alphabet[N]{}, scratch[N]{};
+    size_t lengths[D + 1]{};
+    size_t lottery = 0, digits_count = 0, i = 0;
+
+    for (lottery = 0; lottery < N; ++lottery) {
+        for (i = 0; i < N; ++i) {
+            alphabet[i] = l.alphabets[lottery][i];
+        }
+        for (digits_count = 1; digits_count <= D; ++digits_count) {
+            lengths[digits_count] = digits_count + 3;
+        }
+
+        /* one shuffle a round, shared by every digits count */
+        while (lengths[1] < M) {
+            for (i = 0; i < N; ++i) {
+                scratch[i] = alphabet[i];
+            }
+            shuffle(alphabet, N, scratch, N);
+
+            for (digits_count = 1; digits_count <= D; ++digits_count) {
+                if (lengths[digits_count] < M) {
+                    lengths[digits_count] = pad_step(
+                        result.rows[lottery][digits_count - 1],
+                        lengths[digits_count], M, alphabet, N);
+                }
+            }
+        }
+
+        /* pads are never NUL - the first NUL is the first guard */
+        for (digits_count = 1; digits_count <= D; ++digits_count) {
+            for (i = 0; result.rows[lottery][digits_count - 1][i]; ++i) {
+            }
+            result.left[lottery][digits_count - 1] = (unsigned char)i;
+        }
+    }
+
+    return result;
+}
+
+/* digits of the largest number */
+constexpr size_t
+max_digits(size_t base)
+{
+    unsigned long long number = ~0ull;
+    size_t result = 0;
+
+    do {
+        ++result;
+        number /= base;
+    } while (number);
+
+    return result;
+}
+
+} /* namespace detail */
+
+/* a hashids configuration fixed at compile time */
+template <const char *Salt, std::size_t MinHashLength = 0,
+    const char *Alphabet = default_alphabet>
+class codec {
+    static constexpr detail::tables tables_ =
+        detail::make_tables(Salt, Alphabet);
+
+    static_assert(tables_.error != HASHIDS_ERROR_ALPHABET_LENGTH,
+        "hashids: alphabet is too short");
+    static_assert(tables_.error != HASHIDS_ERROR_ALPHABET_SPACE,
+        "hashids: alphabet contains whitespace characters");
+
+public:
+    /* the final alphabet length - the divisor of every digit */
+    static constexpr std::size_t alphabet_length =
+        tables_.alphabet_length ? tables_.alphabet_length : 1;
+
+    static constexpr std::size_t min_hash_length = MinHashLength;
+
+    /* buffer size for numbers_count numbers, NUL included */
+    static constexpr std::size_t
+    max_encoded_size(std::size_t numbers_count)
+    {
+        std::size_t result = numbers_count * (digits_ + 1);
+
+        return (result > MinHashLength ? result : MinHashLength) + 1;
+    }
+
+    /* hashids_encode() - buffer holds max_encoded_size(numbers_count) */
+    static std::size_t
+    encode(char *buffer, std::size_t numbers_count,
+        const unsigned long long *numbers) noexcept
+    {
+        std::size_t i, lottery, result_len;
+        unsigned long long number, numbers_hash;
+        const char *alphabet;
+        char ch, *buffer_end, *digits_start;
+        char digits[digits_], state[alphabet_length], scratch[alphabet_length];
+
+        if (!numbers_count) {
+            buffer[0] = '\0';
+            return 0;
+        }
+
+        /* walk arguments once and generate a hash */
+        for (i = 0, numbers_hash = 0; i < numbers_count; ++i) {
+            numbers_hash += numbers[i] % (i + 100);
+        }
+
+        /* lottery character, its first shuffle is in the tables */
+        lottery = numbers_hash % alphabet_length;
+        alphabet = lotteries_.alphabets[lottery];
+        buffer[0] = tables_.alphabet[lottery];
+        buffer_end = buffer + 1;
+
+        for (i = 0; i < numbers_count; ++i) {
+            /* the later numbers reshuffle */
+            if (i) {
+                if (alphabet != state) {
+                    std::memcpy(state, alphabet, alphabet_length);
+                    alphabet = state;
+                }
+                detail::shuffle_lottery(state, alphabet_length,
+                    tables_.alphabet[lottery], Salt, salt_length_, scratch);
+            }
+
+            /* hash the number, most significant digit first */
+            number = numbers[i];
+            digits_start = digits + digits_;
+            do {
+                *--digits_start = alphabet[number % alphabet_length];
+                number /= alphabet_length;
+            } while (number);
+
+            ch = *digits_start;
+            std::memcpy(buffer_end, digits_start,
+                digits + digits_ - digits_start);
+            buffer_end += digits + digits_ - digits_start;
+
+            if (i + 1 < numbers_count) {
+                *buffer_end++ = tables_.separators[numbers[i] % (ch + i)
+                    % tables_.separators_count];
+            }
+        }
+
+        result_len = buffer_end - buffer;
+        if (result_len < MinHashLength) {
+            if (numbers_count == 1 && pad_digits_ && result_len + 2 <
+                MinHashLength) {
+                result_len = pad_one(buffer, result_len, numbers_hash,
+                    lottery);
+            } else {
+                if (alphabet != state) {
+                    std::memcpy(state, alphabet, alphabet_length);
+                }
+                result_len = pad(buffer, result_len, numbers_hash, state,
+                    scratch);
+            }
+        }
+
+        buffer[result_len] = '\0';
+        return result_len;
+    }
+
+    /* hashids_encode_one() */
+    static std::size_t
+    encode_one(char *buffer, unsigned long long number) noexcept
+    {
+        return encode(buffer, 1, &number);
+    }
+
+    /* hashids_decode_safe() - 0 for anything encode() would not give, or
+       more than numbers_max numbers */
+    static std::size_t
+    decode(const char *str, unsigned long long *numbers,
+        std::size_t numbers_max)
+    {
+        std::size_t numbers_count, lottery, value;
+        unsigned long long number;
+        const char *p, *c;
+        const unsigned char *values;
+        char state[alphabet_length], scratch[alphabet_length];
+        char stack[decode_stack_];
+        std::unique_ptr<char[]> heap;
+        char *buffer;
+
+        if (!numbers_max) {
+            return 0;
+        }
+
+        /* skip characters until we find a guard */
+        p = str;
+        if (MinHashLength) {
+            for (c = str; *c; ++c) {
+                if (classes_.guard[(unsigned char)*c]) {
+                    p = c + 1;
+                    break;
+                }
+            }
+        }
+
+        /* get the lottery character */
+        lottery = classes_.lottery[(unsigned char)*p];
+        if (!*p || lottery == detail::none) {
+            return 0;
+        }
+        ++p;
+
+        /* parse - the first number straight from the tables */
+        values = lotteries_.values[lottery];
+        numbers_count = 0;
+        number = 0;
+        for (; *p && !classes_.guard[(unsigned char)*p]; ++p) {
+            if (classes_.separator[(unsigned char)*p]) {
+                numbers[numbers_count++] = number;
+                if (numbers_count >= numbers_max) {
+                    return 0;
+                }
+                number = 0;
+
+                /* resalt the alphabet */
+                if (values) {
+                    std::memcpy(state, lotteries_.alphabets[lottery],
+                        alphabet_length);
+                    values = nullptr;
+                }
+                detail::shuffle_lottery(state, alphabet_length,
+                    tables_.alphabet[lottery], Salt, salt_length_, scratch);
+                continue;
+            }
+
+            if (values) {
+                value = values[(unsigned char)*p];
+                if (value == detail::none) {
+                    return 0;
+                }
+            } else {
+                c = static_cast<const char *>(
+                    std::memchr(state, *p, alphabet_length));
+                if (!c) {
+                    return 0;
+                }
+                value = c - state;
+            }
+
+            number = number * alphabet_length + value;
+        }
+        numbers[numbers_count++] = number;
+
+        /* the hash has to be the encoding of what it decodes to */
+        buffer = stack;
+        if (max_encoded_size(numbers_count) > decode_stack_) {
+            heap.reset(new (std::nothrow)
+                char[max_encoded_size(numbers_count)]);
+            if (!heap) {
+                return 0;
+            }
+            buffer = heap.get();
+        }
+
+        encode(buffer, numbers_count, numbers);
+        return std::strcmp(str, buffer) == 0 ? numbers_count : 0;
+    }
+
+private:
+    static constexpr std::size_t salt_length_ = detail::length(Salt);
+    static constexpr std::size_t digits_ = detail::max_digits(alphabet_length);
+
+    /* single numbers with this many digits or fewer use a template */
+    static constexpr std::size_t pad_digits_ =
+        MinHashLength > 4 && MinHashLength <= detail::pad_template_max
+        ? MinHashLength - 4 : 0;
+
+    /* decode() re-encodes this long on the stack */
+    static constexpr std::size_t decode_stack_ =
+        (8 * (digits_ + 1) > MinHashLength ? 8 * (digits_ + 1)
+            : MinHashLength) + 1;
+
+    static constexpr detail::lotteries<alphabet_length> lotteries_ =
+        detail::make_lotteries<alphabet_length>(tables_, Salt);
+
+    static constexpr detail::classes classes_ =
+        detail::make_classes(tables_);
+
+    static constexpr detail::pads<alphabet_length,
+        pad_digits_ ? pad_digits_ : 1, pad_digits_ ? MinHashLength : 1>
+        pads_ = detail::make_pads<alphabet_length,
+            pad_digits_ ? pad_digits_ : 1, pad_digits_ ? MinHashLength : 1>(
+            lotteries_);
+
+    /* hashids_encode_pad() */
+    static std::size_t
+    pad(char *buffer, std::size_t result_len, unsigned long long numbers_hash,
+        char *alphabet, char *scratch) noexcept
+    {
+        /* add a guard before the encoded numbers */
+        std::memmove(buffer + 1, buffer, result_len);
+        buffer[0] = tables_.guards[(numbers_hash + buffer[1])
+            % tables_.guards_count];
+        ++result_len;
+
+        if (result_len < MinHashLength) {
+            /* add a guard after the encoded numbers */
+            buffer[result_len++] = tables_.guards[(numbers_hash + buffer[2])
+                % tables_.guards_count];
+
+            /* pad, pad, pad */
+            while (result_len < MinHashLength) {
+                std::memcpy(scratch, alphabet, alphabet_length);
+                detail::shuffle(alphabet, alphabet_length, scratch,
+                    alphabet_length);
+                result_len = detail::pad_step(buffer, result_len,
+                    MinHashLength, alphabet, alphabet_length);
+            }
+        }
+
+        return result_len;
+    }
+
+    /* hashids_encode_pad_one() - a copy of the template row */
+    static std::size_t
+    pad_one(char *buffer, std::size_t result_len,
+        unsigned long long numbers_hash, std::size_t lottery) noexcept
+    {
+        const std::size_t digits_count = result_len - 1;
+        const std::size_t left = pads_.left[lottery][digits_count - 1];
+        const char lottery_ch = buffer[0], first_ch = buffer[1];
+
+        std::memmove(buffer + left + 1, buffer, result_len);
+        std::memcpy(buffer, pads_.rows[lottery][digits_count - 1], left);
+        buffer[left] = tables_.guards[(numbers_hash + lottery_ch)
+            % tables_.guards_count];
+        buffer[left + 1 + result_len] = tables_.guards[(numbers_hash
+            + first_ch) % tables_.guards_count];
+        std::memcpy(buffer + left + 2 + result_len,
+            pads_.rows[lottery][digits_count - 1] + left + 2 + result_len,
+            MinHashLength - left - 2 - result_len);
+
+        return MinHashLength;
+    }
+};
+
+} /* namespace hashids */
+
+#endif
@@ -6,6 +6,9 @@
 
 enum { COMMAND_ENCODE = 0, COMMAND_DECODE = 1 };
 
+/* decoded numbers kept on the stack */
+#define NUMBERS_INLINE 4
+
 static void
 usage(const char *program_invocation_name, FILE *out)
 {
@@ -13,6 +16,8 @@ usage(const char *program_invocation_name, FILE *out)
     fputs("Usage:\n", out);
     fprintf(out, "  %s [options] <arguments>\n",
         program_invocation_name);
+    fprintf(out, "  %s [options] -D <file> <count>\n",
+        program_invocation_name);
 
     fputs("\n", out);
     fputs("Options:\n", out);
@@ -23,7 +28,10 @@ usage(const char *program_invocation_name, FILE *out)
         out);
     fprintf(out, "  -l, --min-length  set hash minimum length [%u]\n",
         HASHIDS_DEFAULT_MIN_HASH_LENGTH);
-    fputs("  -x, --hex         encode / decode hex strings\n", out);
+    fputs("  -x, --hex         encode / decode hex strings of any length\n",
+        out);
+    fputs("  -D, --dictionary  write the hashes of [0, <count>) to a file\n",
+        out);
     fputs("  -h, --help        display this help and exit\n", out);
     fputs("  -v, --version     print version information and exit\n", out);
 
@@ -54,10 +62,12 @@ main(int argc, char **argv)
 {
     hashids_t *hashids;
     char *salt = HASHIDS_DEFAULT_SALT, *alphabet = HASHIDS_DEFAULT_ALPHABET,
-        *buffer, *p, str[18];
+        *dictionary = NULL, *buffer, *p;
     unsigned int command = COMMAND_ENCODE, hex = 0;
-    size_t min_hash_length = HASHIDS_DEFAULT_MIN_HASH_LENGTH, numbers_count;
-    unsigned long long number, *numbers, *numbers_ptr;
+    size_t min_hash_length = HASHIDS_DEFAULT_MIN_HASH_LENGTH, numbers_count,
+        length;
+    unsigned long long *numbers, *numbers_ptr, count,
+        numbers_inline[NUMBERS_INLINE];
     int ch, i, j;
 
     static const struct option longopts[] = {
@@ -67,13 +77,14 @@ main(int argc, char **argv)
         {"alphabet", required_argument, NULL, 'a'},
         {"min-length", required_argument, NULL, 'l'},
         {"hex", no_argument, NULL, 'x'},
+        {"dictionary", required_argument, NULL, 'D'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {NULL, 0, NULL, 0}
     };
 
     /* parse command line options */
-    while ((ch = getopt_long(argc, argv, "+eds:a:l:xhv", longopts,
+    while ((ch = getopt_long(argc, argv, "+eds:a:l:xD:hv", longopts,
         NULL)) != -1) {
         switch (ch) {
             case 'e':
@@ -98,6 +109,9 @@ main(int argc, char **argv)
             case 'x':
                 hex = 1;
                 break;
+            case 'D':
+                dictionary = optarg;
+                break;
             case 'h':
                 usage(argv[0], stdout);
                 break;
@@ -138,26 +152,69 @@ main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    /* dictionary */
+    if (dictionary) {
+        if (optind + 1 != argc) {
+            hashids_free(hashids);
+            usage(argv[0], stderr);
+        }
+
+        count = parse_number(argv[optind], &p);
+        if (p == argv[optind]) {
+            fprintf(stderr, "Invalid number: %s\n", argv[optind]);
+            hashids_free(hashids);
+            return EXIT_FAILURE;
+        }
+
+        /* build, report, cleanup */
+        switch (hashids_dict_save(dictionary, hashids, count)) {
+            case HASHIDS_ERROR_OK:
+                hashids_free(hashids);
+                return EXIT_SUCCESS;
+            case HASHIDS_ERROR_ALLOC:
+                fputs("Hashids: Allocation failed\n", stderr);
+                break;
+            case HASHIDS_ERROR_INVALID_NUMBER:
+                fprintf(stderr, "Hashids: Count is too large: %s\n",
+                    argv[optind]);
+                break;
+            case HASHIDS_ERROR_IO:
+                fprintf(stderr, "Hashids: Cannot write %s\n", dictionary);
+                break;
+            default:
+                fputs("Hashids: Unknown error\n", stderr);
+                break;
+        }
+
+        hashids_free(hashids);
+        return EXIT_FAILURE;
+    }
+
     /* encode */
     if (command == COMMAND_ENCODE) {
         /* hex mode */
         if (hex) {
-            number = (unsigned long long)-1;
-            buffer = (char *)calloc(
-                hashids_estimate_encoded_size(hashids, 1, &number), 1);
+            for (i = optind; i < argc; ++i) {
+                buffer = (char *)calloc(
+                    hashids_encode_hex_big(hashids, NULL, argv[i]), 1);
 
-            if (!buffer) {
-                fputs("Cannot allocate memory for buffer\n", stderr);
-                hashids_free(hashids);
-                return EXIT_FAILURE;
-            }
+                if (!buffer) {
+                    fputs("Cannot allocate memory for buffer\n", stderr);
+                    hashids_free(hashids);
+                    return EXIT_FAILURE;
+                }
+
+                if (!hashids_encode_hex_big(hashids, buffer, argv[i])) {
+                    fprintf(stderr, "Invalid hex string: %s\n", argv[i]);
+                    free(buffer);
+                    hashids_free(hashids);
+                    return EXIT_FAILURE;
+                }
 
-            for (i = optind; i < argc; ++i) {
-                hashids_encode_hex(hashids, buffer, argv[i]);
                 printf("%s\n", buffer);
+                free(buffer);
             }
 
-            free(buffer);
             hashids_free(hashids);
             return EXIT_SUCCESS;
         }
@@ -208,8 +265,25 @@ main(int argc, char **argv)
     /* decode */
     if (hex) {
         for (i = optind; i < argc; ++i) {
-            hashids_decode_hex(hashids, argv[i], str);
-            printf("%s\n", str);
+            length = hashids_decode_hex_big(hashids, argv[i], NULL, 0);
+
+            if (hashids_errno != HASHIDS_ERROR_OK) {
+                fprintf(stderr, "Hashids: Invalid hash: %s\n", argv[i]);
+                hashids_free(hashids);
+                return EXIT_FAILURE;
+            }
+
+            buffer = (char *)calloc(length + 1, 1);
+
+            if (!buffer) {
+                fputs("Cannot allocate memory for buffer\n", stderr);
+                hashids_free(hashids);
+                return EXIT_FAILURE;
+            }
+
+            hashids_decode_hex_big(hashids, argv[i], buffer, length + 1);
+            printf("%s\n", buffer);
+            free(buffer);
         }
 
         hashids_free(hashids);
@@ -217,34 +291,41 @@ main(int argc, char **argv)
     }
 
     for (i = optind; i < argc; ++i) {
-        numbers_count = hashids_numbers_count(hashids, argv[i]);
+        /* most hashes fit inline - one pass, no allocation */
+        numbers = numbers_inline;
+        numbers_count = hashids_decode_into(hashids, argv[i], numbers,
+            NUMBERS_INLINE);
+
+        if (numbers_count > NUMBERS_INLINE) {
+            numbers = (unsigned long long *)calloc(numbers_count,
+                sizeof(unsigned long long));
+
+            if (!numbers) {
+                fprintf(stderr, "Cannot allocate memory for numbers\n");
+                hashids_free(hashids);
+                return EXIT_FAILURE;
+            }
+
+            numbers_count = hashids_decode_into(hashids, argv[i], numbers,
+                numbers_count);
+        }
 
         if (!numbers_count) {
             switch (hashids_errno) {
                 case HASHIDS_ERROR_INVALID_HASH:
                     fprintf(stderr, "Hashids: Invalid hash: %s\n", argv[i]);
                     break;
+                case HASHIDS_ERROR_ALLOC:
+                    fputs("Hashids: Allocation failed\n", stderr);
+                    break;
                 default:
                     fputs("Hashids: Unknown error\n", stderr);
                     break;
             }
 
-            hashids_free(hashids);
-            return EXIT_FAILURE;
-        }
-
-        numbers = (unsigned long long *)calloc(numbers_count,
-            sizeof(unsigned long long));
-
-        if (!numbers) {
-            fprintf(stderr, "Cannot allocate memory for numbers\n");
-            hashids_free(hashids);
-            return EXIT_FAILURE;
-        }
-
-        if (hashids_decode_safe(hashids, argv[i], numbers, numbers_count) !=
-            numbers_count) {
-            fprintf(stderr, "Could not decode numbers properly\n");
+            if (numbers != numbers_inline) {
+                free(numbers);
+            }
             hashids_free(hashids);
             return EXIT_FAILURE;
         }
@@ -257,7 +338,9 @@ main(int argc, char **argv)
         }
         printf("\n");
 
-        free(numbers);
+        if (numbers != numbers_inline) {
+            free(numbers);
+        }
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,657 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "hashids.h"
+
+/* shard count - a power of two */
+#define HASHIDS_MEMO_SHARDS 16u
+
+/* tuples & hashes larger than these go straight to the instance */
+#define HASHIDS_MEMO_MAX_NUMBERS 4u
+#define HASHIDS_MEMO_MAX_HASH 47u
+
+/* batch inputs deduplicated at a time */
+#define HASHIDS_MEMO_BLOCK 4096u
+
+/* a memoized tuple & its hash - the same in both directions */
+struct hashids_memo_entry_s {
+    unsigned long long key;
+    unsigned long long numbers[HASHIDS_MEMO_MAX_NUMBERS];
+    uint32_t chain;
+    unsigned char numbers_count;
+    unsigned char length;
+    unsigned char referenced;
+    char hash[HASHIDS_MEMO_MAX_HASH + 1];
+};
+
+/* a shard: fixed entries, bucket chains (index + 1), a CLOCK hand & a lock */
+struct hashids_memo_shard_s {
+    pthread_mutex_t lock;
+    struct hashids_memo_entry_s *entries;
+    uint32_t *buckets;
+    size_t buckets_mask;
+    size_t count;
+    size_t capacity;
+    size_t hand;
+
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+};
+
+/* the memo "object" - tuples to hashes & hashes to tuples */
+struct hashids_memo_s {
+    hashids_t *hashids;
+
+    struct hashids_memo_shard_s encode[HASHIDS_MEMO_SHARDS];
+    struct hashids_memo_shard_s decode[HASHIDS_MEMO_SHARDS];
+
+    pthread_mutex_t lock;
+    unsigned long long duplicates;
+};
+
+/* hash of a tuple */
+static inline unsigned long long
+hashids_memo_numbers_key(size_t numbers_count,
+    const unsigned long long *numbers)
+{
+    unsigned long long key = 0xCBF29CE484222325ull ^ numbers_count;
+    size_t i;
+
+    for (i = 0; i < numbers_count; ++i) {
+        key = (key ^ numbers[i]) * 0x9E3779B97F4A7C15ull;
+        key ^= key >> 32;
+    }
+
+    return key ^ (key >> 29);
+}
+
+/* hash of a hash */
+static inline unsigned long long
+hashids_memo_hash_key(const char *str, size_t length)
+{
+    unsigned long long key = 0xCBF29CE484222325ull, word;
+
+    for (; length >= sizeof(word); length -= sizeof(word)) {
+        memcpy(&word, str, sizeof(word));
+        str += sizeof(word);
+        key = (key ^ word) * 0x9E3779B97F4A7C15ull;
+        key ^= key >> 32;
+    }
+
+    word = 0;
+    memcpy(&word, str, length);
+    key = (key ^ word ^ ((unsigned long long)length << 56))
+        * 0x9E3779B97F4A7C15ull;
+
+    return key ^ (key >> 29);
+}
+
+/* the low bits pick the bucket, the high bits pick the shard */
+static inline struct hashids_memo_shard_s *
+hashids_memo_shard(struct hashids_memo_shard_s *shards,
+    unsigned long long key)
+{
+    return &shards[(key >> 60) & (HASHIDS_MEMO_SHARDS - 1)];
+}
+
+/* find a tuple (shard lock held) */
+static struct hashids_memo_entry_s *
+hashids_memo_find_numbers(struct hashids_memo_shard_s *shard,
+    unsigned long long key, size_t numbers_count,
+    const unsigned long long *numbers)
+{
+    struct hashids_memo_entry_s *entry;
+    uint32_t i;
+
+    for (i = shard->buckets[key & shard->buckets_mask]; i; i = entry->chain) {
+        entry = &shard->entries[i - 1];
+        if (entry->key == key && entry->numbers_count == numbers_count
+            && memcmp(entry->numbers, numbers,
+                numbers_count * sizeof(*numbers)) == 0) {
+            entry->referenced = 1;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* find a hash (shard lock held) */
+static struct hashids_memo_entry_s *
+hashids_memo_find_hash(struct hashids_memo_shard_s *shard,
+    unsigned long long key, const char *str, size_t length)
+{
+    struct hashids_memo_entry_s *entry;
+    uint32_t i;
+
+    for (i = shard->buckets[key & shard->buckets_mask]; i; i = entry->chain) {
+        entry = &shard->entries[i - 1];
+        if (entry->key == key && entry->length == length
+            && memcmp(entry->hash, str, length) == 0) {
+            entry->referenced = 1;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* a free entry, or the first one CLOCK finds unreferenced (shard lock
+   held) */
+static struct hashids_memo_entry_s *
+hashids_memo_victim(struct hashids_memo_shard_s *shard)
+{
+    struct hashids_memo_entry_s *entry;
+    uint32_t *link;
+
+    if (shard->count < shard->capacity) {
+        return &shard->entries[shard->count++];
+    }
+
+    /* give referenced entries a second chance */
+    for (;;) {
+        entry = &shard->entries[shard->hand];
+        shard->hand = shard->hand + 1 < shard->capacity ? shard->hand + 1 : 0;
+        if (!entry->referenced) {
+            break;
+        }
+        entry->referenced = 0;
+    }
+
+    for (link = &shard->buckets[entry->key & shard->buckets_mask];
+        *link != (uint32_t)(entry - shard->entries) + 1;
+        link = &shard->entries[*link - 1].chain) {
+        /* empty */
+    }
+    *link = entry->chain;
+    ++shard->evictions;
+
+    return entry;
+}
+
+/* remember a tuple & its hash in both directions */
+static void
+hashids_memo_store(hashids_memo_t *memo, size_t numbers_count,
+    const unsigned long long *numbers, const char *str, size_t length)
+{
+    struct hashids_memo_shard_s *shard;
+    struct hashids_memo_entry_s *entry;
+    unsigned long long keys[2];
+    size_t i;
+
+    keys[0] = hashids_memo_numbers_key(numbers_count, numbers);
+    keys[1] = hashids_memo_hash_key(str, length);
+
+    for (i = 0; i < 2; ++i) {
+        shard = hashids_memo_shard(i ? memo->decode : memo->encode, keys[i]);
+        pthread_mutex_lock(&shard->lock);
+
+        /* somebody might have been faster */
+        if (i ? hashids_memo_find_hash(shard, keys[i], str, length)
+            : hashids_memo_find_numbers(shard, keys[i], numbers_count,
+                numbers)) {
+            pthread_mutex_unlock(&shard->lock);
+            continue;
+        }
+
+        entry = hashids_memo_victim(shard);
+        entry->key = keys[i];
+        memcpy(entry->numbers, numbers, numbers_count * sizeof(*numbers));
+        entry->numbers_count = (unsigned char)numbers_count;
+        memcpy(entry->hash, str, length + 1);
+        entry->length = (unsigned char)length;
+        entry->referenced = 0;
+        entry->chain = shard->buckets[keys[i] & shard->buckets_mask];
+        shard->buckets[keys[i] & shard->buckets_mask] =
+            (uint32_t)(entry - shard->entries) + 1;
+
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+/* "destructor" */
+void
+hashids_memo_free(hashids_memo_t *memo)
+{
+    struct hashids_memo_shard_s *shard;
+    size_t i;
+
+    if (!memo) {
+        return;
+    }
+
+    for (i = 0; i < HASHIDS_MEMO_SHARDS * 2; ++i) {
+        shard = i < HASHIDS_MEMO_SHARDS ? &memo->encode[i]
+            : &memo->decode[i - HASHIDS_MEMO_SHARDS];
+        if (shard->entries) {
+            _hashids_free(shard->entries);
+        }
+        if (shard->buckets) {
+            _hashids_free(shard->buckets);
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    pthread_mutex_destroy(&memo->lock);
+    _hashids_free(memo);
+}
+
+/* "constructor" - capacity tuples in each direction */
+hashids_memo_t *
+hashids_memo_init(hashids_t *hashids, size_t capacity)
+{
+    hashids_memo_t *result;
+    struct hashids_memo_shard_s *shard;
+    size_t i, per_shard, buckets;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    result = (hashids_memo_t *)_hashids_alloc(sizeof(hashids_memo_t));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+    result->hashids = hashids;
+    pthread_mutex_init(&result->lock, NULL);
+
+    /* split the capacity, keep chains short */
+    per_shard = (capacity + HASHIDS_MEMO_SHARDS - 1) / HASHIDS_MEMO_SHARDS;
+    if (!per_shard) {
+        per_shard = 1;
+    }
+    for (buckets = 4; buckets < per_shard * 2; buckets <<= 1) {
+        /* empty */
+    }
+
+    for (i = 0; i < HASHIDS_MEMO_SHARDS * 2; ++i) {
+        shard = i < HASHIDS_MEMO_SHARDS ? &result->encode[i]
+            : &result->decode[i - HASHIDS_MEMO_SHARDS];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = per_shard;
+        shard->buckets_mask = buckets - 1;
+        shard->entries = (struct hashids_memo_entry_s *)_hashids_alloc(
+            per_shard * sizeof(struct hashids_memo_entry_s));
+        shard->buckets = (uint32_t *)_hashids_alloc(
+            buckets * sizeof(uint32_t));
+        if (!shard->entries || !shard->buckets) {
+            for (++i; i < HASHIDS_MEMO_SHARDS * 2; ++i) {
+                pthread_mutex_init(i < HASHIDS_MEMO_SHARDS
+                    ? &result->encode[i].lock
+                    : &result->decode[i - HASHIDS_MEMO_SHARDS].lock, NULL);
+            }
+            hashids_memo_free(result);
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+/* hashids_encode() through the memo */
+size_t
+hashids_memo_encode(hashids_memo_t *memo, char *buffer, size_t numbers_count,
+    unsigned long long *numbers)
+{
+    struct hashids_memo_shard_s *shard;
+    struct hashids_memo_entry_s *entry;
+    unsigned long long key;
+    size_t result;
+
+    if (!buffer || !numbers_count
+        || numbers_count > HASHIDS_MEMO_MAX_NUMBERS) {
+        return hashids_encode(memo->hashids, buffer, numbers_count, numbers);
+    }
+
+    key = hashids_memo_numbers_key(numbers_count, numbers);
+    shard = hashids_memo_shard(memo->encode, key);
+
+    pthread_mutex_lock(&shard->lock);
+    entry = hashids_memo_find_numbers(shard, key, numbers_count, numbers);
+    if (entry) {
+        ++shard->hits;
+        result = entry->length;
+        memcpy(buffer, entry->hash, result + 1);
+        pthread_mutex_unlock(&shard->lock);
+        return result;
+    }
+    ++shard->misses;
+    pthread_mutex_unlock(&shard->lock);
+
+    result = hashids_encode(memo->hashids, buffer, numbers_count, numbers);
+    if (result && result <= HASHIDS_MEMO_MAX_HASH) {
+        hashids_memo_store(memo, numbers_count, numbers, buffer, result);
+    }
+
+    return result;
+}
+
+/* hashids_decode_safe() through the memo */
+size_t
+hashids_memo_decode(hashids_memo_t *memo, const char *str,
+    unsigned long long *numbers, size_t numbers_max)
+{
+    struct hashids_memo_shard_s *shard;
+    struct hashids_memo_entry_s *entry;
+    unsigned long long key;
+    size_t result, length;
+
+    if (!numbers || !numbers_max) {
+        return hashids_decode_safe(memo->hashids, str, numbers, numbers_max);
+    }
+
+    length = strlen(str);
+    if (length <= HASHIDS_MEMO_MAX_HASH) {
+        key = hashids_memo_hash_key(str, length);
+        shard = hashids_memo_shard(memo->decode, key);
+
+        pthread_mutex_lock(&shard->lock);
+        entry = hashids_memo_find_hash(shard, key, str, length);
+        if (entry) {
+            ++shard->hits;
+            result = entry->numbers_count;
+            if (result > numbers_max) {
+                /* hashids_decode_safe() can't re-encode a partial tuple */
+                pthread_mutex_unlock(&shard->lock);
+                hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+                return 0;
+            }
+            memcpy(numbers, entry->numbers, result * sizeof(*numbers));
+            pthread_mutex_unlock(&shard->lock);
+            return result;
+        }
+        ++shard->misses;
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    result = hashids_decode_safe(memo->hashids, str, numbers, numbers_max);
+    if (result && result <= HASHIDS_MEMO_MAX_NUMBERS
+        && length <= HASHIDS_MEMO_MAX_HASH) {
+        hashids_memo_store(memo, result, numbers, str, length);
+    }
+
+    return result;
+}
+
+/* batch scratch - a dedup table, the first slot of every input & misses */
+struct hashids_memo_batch_s {
+    uint32_t *table;
+    size_t table_mask;
+    uint32_t *first;
+    uint32_t *misses;
+    unsigned long long *numbers;
+    unsigned char *valid;
+    char *buffer;
+};
+
+/* scratch for up to HASHIDS_MEMO_BLOCK inputs at a time */
+static int
+hashids_memo_batch_init(struct hashids_memo_batch_s *batch, size_t count,
+    size_t stride)
+{
+    size_t table_size;
+    char *p;
+
+    if (count > HASHIDS_MEMO_BLOCK) {
+        count = HASHIDS_MEMO_BLOCK;
+    }
+    for (table_size = 16; table_size < count * 2; table_size <<= 1) {
+        /* empty */
+    }
+
+    p = (char *)_hashids_alloc(count * sizeof(unsigned long long)
+        + (table_size + count * 2) * sizeof(uint32_t) + count
+        + count * stride);
+    if (!p) {
+        return 0;
+    }
+
+    batch->numbers = (unsigned long long *)p;
+    p += count * sizeof(unsigned long long);
+    batch->table = (uint32_t *)p;
+    batch->table_mask = table_size - 1;
+    p += table_size * sizeof(uint32_t);
+    batch->first = (uint32_t *)p;
+    p += count * sizeof(uint32_t);
+    batch->misses = (uint32_t *)p;
+    p += count * sizeof(uint32_t);
+    batch->valid = (unsigned char *)p;
+    p += count;
+    batch->buffer = p;
+
+    return 1;
+}
+
+/* count the duplicates of a batch */
+static void
+hashids_memo_duplicates(hashids_memo_t *memo, size_t duplicates)
+{
+    if (duplicates) {
+        pthread_mutex_lock(&memo->lock);
+        memo->duplicates += duplicates;
+        pthread_mutex_unlock(&memo->lock);
+    }
+}
+
+/* hashids_encode_one_batch() through the memo, repeated numbers encoded
+   once */
+size_t
+hashids_memo_encode_one_batch(hashids_memo_t *memo, char *buffer,
+    size_t buffer_stride, const unsigned long long *numbers,
+    size_t numbers_count)
+{
+    struct hashids_memo_batch_s batch;
+    struct hashids_memo_shard_s *shard;
+    struct hashids_memo_entry_s *entry;
+    unsigned long long key, largest = 0xFFFFFFFFFFFFFFFFull;
+    size_t i, j, block, count, misses, duplicates, length;
+    char *slot;
+
+    if (buffer_stride
+        < hashids_estimate_encoded_size(memo->hashids, 1, &largest)) {
+        return 0;
+    }
+    if (!hashids_memo_batch_init(&batch, numbers_count, buffer_stride)) {
+        return hashids_encode_one_batch(memo->hashids, buffer, buffer_stride,
+            numbers, numbers_count);
+    }
+
+    for (block = 0, duplicates = 0; block < numbers_count;
+        block += HASHIDS_MEMO_BLOCK) {
+        count = numbers_count - block < HASHIDS_MEMO_BLOCK
+            ? numbers_count - block : HASHIDS_MEMO_BLOCK;
+        memset(batch.table, 0, (batch.table_mask + 1) * sizeof(uint32_t));
+
+        for (i = 0, misses = 0; i < count; ++i) {
+            key = hashids_memo_numbers_key(1, numbers + block + i);
+
+            /* seen earlier in the block */
+            for (j = key & batch.table_mask; batch.table[j]
+                && numbers[block + batch.table[j] - 1] != numbers[block + i];
+                j = (j + 1) & batch.table_mask) {
+                /* empty */
+            }
+            if (batch.table[j]) {
+                batch.first[i] = batch.table[j] - 1;
+                ++duplicates;
+                continue;
+            }
+            batch.table[j] = (uint32_t)i + 1;
+            batch.first[i] = (uint32_t)i;
+
+            shard = hashids_memo_shard(memo->encode, key);
+            slot = buffer + (block + i) * buffer_stride;
+            pthread_mutex_lock(&shard->lock);
+            entry = hashids_memo_find_numbers(shard, key, 1,
+                numbers + block + i);
+            if (entry) {
+                ++shard->hits;
+                memcpy(slot, entry->hash, entry->length + 1);
+            } else {
+                ++shard->misses;
+                batch.numbers[misses] = numbers[block + i];
+                batch.misses[misses++] = (uint32_t)i;
+            }
+            pthread_mutex_unlock(&shard->lock);
+        }
+
+        /* the misses in one go */
+        hashids_encode_one_batch(memo->hashids, batch.buffer, buffer_stride,
+            batch.numbers, misses);
+        for (i = 0; i < misses; ++i) {
+            slot = batch.buffer + i * buffer_stride;
+            length = strlen(slot);
+            memcpy(buffer + (block + batch.misses[i]) * buffer_stride, slot,
+                length + 1);
+            if (length <= HASHIDS_MEMO_MAX_HASH) {
+                hashids_memo_store(memo, 1, batch.numbers + i, slot, length);
+            }
+        }
+
+        for (i = 0; i < count; ++i) {
+            if (batch.first[i] != i) {
+                strcpy(buffer + (block + i) * buffer_stride,
+                    buffer + (block + batch.first[i]) * buffer_stride);
+            }
+        }
+    }
+
+    hashids_memo_duplicates(memo, duplicates);
+    _hashids_free(batch.numbers);
+
+    return numbers_count;
+}
+
+/* hashids_decode_one_batch() through the memo, repeated hashes decoded
+   once */
+size_t
+hashids_memo_decode_one_batch(hashids_memo_t *memo, const char *strs,
+    size_t strs_stride, size_t strs_count, unsigned long long *numbers,
+    unsigned char *valid)
+{
+    struct hashids_memo_batch_s batch;
+    struct hashids_memo_shard_s *shard;
+    struct hashids_memo_entry_s *entry;
+    unsigned long long key;
+    size_t i, j, block, count, misses, duplicates, length, result;
+    const char *str;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (!hashids_memo_batch_init(&batch, strs_count, strs_stride)) {
+        return hashids_decode_one_batch(memo->hashids, strs, strs_stride,
+            strs_count, numbers, valid);
+    }
+
+    for (block = 0, duplicates = 0, result = 0; block < strs_count;
+        block += HASHIDS_MEMO_BLOCK) {
+        count = strs_count - block < HASHIDS_MEMO_BLOCK
+            ? strs_count - block : HASHIDS_MEMO_BLOCK;
+        memset(batch.table, 0, (batch.table_mask + 1) * sizeof(uint32_t));
+
+        for (i = 0, misses = 0; i < count; ++i) {
+            str = strs + (block + i) * strs_stride;
+            length = strlen(str);
+            key = hashids_memo_hash_key(str, length);
+
+            /* seen earlier in the block */
+            for (j = key & batch.table_mask; batch.table[j]
+                && strcmp(strs + (block + batch.table[j] - 1) * strs_stride,
+                    str) != 0;
+                j = (j + 1) & batch.table_mask) {
+                /* empty */
+            }
+            if (batch.table[j]) {
+                batch.first[i] = batch.table[j] - 1;
+                ++duplicates;
+                continue;
+            }
+            batch.table[j] = (uint32_t)i + 1;
+            batch.first[i] = (uint32_t)i;
+
+            entry = NULL;
+            if (length <= HASHIDS_MEMO_MAX_HASH) {
+                shard = hashids_memo_shard(memo->decode, key);
+                pthread_mutex_lock(&shard->lock);
+                entry = hashids_memo_find_hash(shard, key, str, length);
+                if (entry) {
+                    ++shard->hits;
+                    valid[block + i] = entry->numbers_count == 1;
+                    numbers[block + i] = valid[block + i]
+                        ? entry->numbers[0] : 0;
+                } else {
+                    ++shard->misses;
+                }
+                pthread_mutex_unlock(&shard->lock);
+            }
+            if (!entry) {
+                memcpy(batch.buffer + misses * strs_stride, str, length + 1);
+                batch.misses[misses++] = (uint32_t)i;
+            }
+        }
+
+        /* the misses in one go */
+        hashids_decode_one_batch(memo->hashids, batch.buffer, strs_stride,
+            misses, batch.numbers, batch.valid);
+        for (i = 0; i < misses; ++i) {
+            j = block + batch.misses[i];
+            valid[j] = batch.valid[i];
+            numbers[j] = batch.numbers[i];
+            str = batch.buffer + i * strs_stride;
+            length = strlen(str);
+            if (valid[j] && length <= HASHIDS_MEMO_MAX_HASH) {
+                hashids_memo_store(memo, 1, batch.numbers + i, str, length);
+            }
+        }
+
+        for (i = 0; i < count; ++i) {
+            if (batch.first[i] != i) {
+                valid[block + i] = valid[block + batch.first[i]];
+                numbers[block + i] = numbers[block + batch.first[i]];
+            }
+            result += valid[block + i];
+        }
+    }
+
+    hashids_memo_duplicates(memo, duplicates);
+    _hashids_free(batch.numbers);
+
+    return result;
+}
+
+/* hit, miss, eviction & duplicate counts so far */
+void
+hashids_memo_stats(hashids_memo_t *memo, hashids_memo_stats_t *stats)
+{
+    struct hashids_memo_shard_s *shard;
+    size_t i;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (i = 0; i < HASHIDS_MEMO_SHARDS; ++i) {
+        shard = &memo->encode[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->encode_hits += shard->hits;
+        stats->encode_misses += shard->misses;
+        stats->evictions += shard->evictions;
+        pthread_mutex_unlock(&shard->lock);
+
+        shard = &memo->decode[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->decode_hits += shard->hits;
+        stats->decode_misses += shard->misses;
+        stats->evictions += shard->evictions;
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    pthread_mutex_lock(&memo->lock);
+    stats->duplicates = memo->duplicates;
+    pthread_mutex_unlock(&memo->lock);
+}
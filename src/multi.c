@@ -0,0 +1,145 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hashids.h"
+
+/* configurations a multi decoder holds - a bit each */
+#define HASHIDS_MULTI_MAX 64u
+
+/* the multi decoder "object" - per character, the configurations that have
+   it at all, in the alphabet & as a guard */
+struct hashids_multi_s {
+    hashids_t *instances[HASHIDS_MULTI_MAX];
+    size_t count;
+
+    unsigned long long any[256];
+    unsigned long long alphabet[256];
+    unsigned long long guards[256];
+
+    /* configurations with a min_hash_length */
+    unsigned long long padded;
+    unsigned long long all;
+};
+
+/* "destructor" - the instances are left alone */
+void
+hashids_multi_free(hashids_multi_t *multi)
+{
+    if (multi) {
+        _hashids_free(multi);
+    }
+}
+
+/* "constructor" - the instances have to outlive the decoder */
+hashids_multi_t *
+hashids_multi_init(hashids_t **instances, size_t count)
+{
+    hashids_multi_t *result;
+    hashids_t *hashids;
+    unsigned long long bit;
+    size_t i, j;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    if (count > HASHIDS_MULTI_MAX) {
+        hashids_errno = HASHIDS_ERROR_LIMIT;
+        return NULL;
+    }
+
+    result = (hashids_multi_t *)_hashids_alloc(sizeof(hashids_multi_t));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    result->count = count;
+    for (i = 0; i < count; ++i) {
+        hashids = result->instances[i] = instances[i];
+        bit = 1ull << i;
+
+        for (j = 0; j < hashids->alphabet_length; ++j) {
+            result->any[(unsigned char)hashids->alphabet[j]] |= bit;
+            result->alphabet[(unsigned char)hashids->alphabet[j]] |= bit;
+        }
+        for (j = 0; j < hashids->separators_count; ++j) {
+            result->any[(unsigned char)hashids->separators[j]] |= bit;
+        }
+        for (j = 0; j < hashids->guards_count; ++j) {
+            result->any[(unsigned char)hashids->guards[j]] |= bit;
+            result->guards[(unsigned char)hashids->guards[j]] |= bit;
+        }
+
+        if (hashids->min_hash_length) {
+            result->padded |= bit;
+        }
+        result->all |= bit;
+    }
+
+    return result;
+}
+
+/* configurations that might have given the hash, from one look at it */
+static unsigned long long
+hashids_multi_candidates(hashids_multi_t *multi, const char *str)
+{
+    const unsigned char *p;
+    unsigned long long candidates, guards;
+    size_t i, length;
+
+    /* every character has to belong */
+    candidates = multi->all;
+    guards = 0;
+    for (p = (const unsigned char *)str; *p && candidates; ++p) {
+        candidates &= multi->any[*p];
+        guards |= multi->guards[*p];
+    }
+    length = (const char *)p - str;
+
+    /* without padding there are no guards, and the lottery comes first */
+    candidates &= ~(guards & ~multi->padded);
+    candidates &= multi->alphabet[(unsigned char)str[0]] | multi->padded;
+
+    /* a hash without guards is at least min_hash_length long */
+    for (i = 0; i < multi->count; ++i) {
+        if ((candidates >> i & 1) && !(guards >> i & 1)
+            && length < multi->instances[i]->min_hash_length) {
+            candidates &= ~(1ull << i);
+        }
+    }
+
+    return candidates;
+}
+
+/* hashids_decode_into() with the first configuration that gave the hash */
+size_t
+hashids_multi_decode(hashids_multi_t *multi, const char *str,
+    unsigned long long *numbers, size_t numbers_max, size_t *index)
+{
+    unsigned long long candidates;
+    size_t i, result;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    candidates = hashids_multi_candidates(multi, str);
+    for (i = 0; candidates; ++i, candidates >>= 1) {
+        if (!(candidates & 1)) {
+            continue;
+        }
+
+        result = hashids_decode_into(multi->instances[i], str, numbers,
+            numbers_max);
+        if (result) {
+            if (index) {
+                *index = i;
+            }
+            return result;
+        }
+    }
+
+    hashids_errno = HASHIDS_ERROR_INVALID_HASH;
+    return 0;
+}
@@ -0,0 +1,257 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "hashids.h"
+
+/* a worker: the task indices it owns, stolen from the back by the others */
+struct hashids_pool_worker_s {
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+
+    pthread_t thread;
+    struct hashids_pool_s *pool;
+    size_t index;
+};
+
+/* the pool "object" - worker 0 is whoever calls run */
+struct hashids_pool_s {
+    hashids_executor_t executor;
+
+    pthread_mutex_t run_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t generation;
+    size_t pending;
+    int stop;
+
+    void (*task)(void *arg, size_t index, size_t worker);
+    void *arg;
+
+    size_t workers_count;
+    struct hashids_pool_worker_s workers[1];
+};
+
+/* take a task index - our own first, then half of somebody else's */
+static int
+hashids_pool_take(hashids_pool_t *pool, size_t worker, size_t *index)
+{
+    struct hashids_pool_worker_s *own, *victim;
+    size_t i, begin, end;
+    int result = 0;
+
+    own = &pool->workers[worker];
+    pthread_mutex_lock(&own->lock);
+    if (own->begin < own->end) {
+        *index = own->begin++;
+        result = 1;
+    }
+    pthread_mutex_unlock(&own->lock);
+    if (result) {
+        return 1;
+    }
+
+    for (i = 1; i < pool->workers_count; ++i) {
+        victim = &pool->workers[(worker + i) % pool->workers_count];
+        pthread_mutex_lock(&victim->lock);
+        begin = victim->end;
+        end = victim->end;
+        if (victim->begin < victim->end) {
+            begin = victim->end - (victim->end - victim->begin + 1) / 2;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            *index = begin;
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin + 1;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* run tasks until there are none left to take */
+static void
+hashids_pool_work(hashids_pool_t *pool, size_t worker)
+{
+    size_t index;
+
+    while (hashids_pool_take(pool, worker, &index)) {
+        pool->task(pool->arg, index, worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (!--pool->pending) {
+            pthread_cond_broadcast(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* a pool thread */
+static void *
+hashids_pool_thread(void *arg)
+{
+    struct hashids_pool_worker_s *worker;
+    hashids_pool_t *pool;
+    size_t generation = 0;
+
+    worker = (struct hashids_pool_worker_s *)arg;
+    pool = worker->pool;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && generation == pool->generation) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        generation = pool->generation;
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        hashids_pool_work(pool, worker->index);
+    }
+}
+
+/* the executor callback - split the indices evenly, then steal */
+static void
+hashids_pool_run(void *ctx, void (*task)(void *arg, size_t index,
+    size_t worker), void *arg, size_t tasks_count)
+{
+    hashids_pool_t *pool;
+    struct hashids_pool_worker_s *worker;
+    size_t i;
+
+    pool = (hashids_pool_t *)ctx;
+    if (!tasks_count) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = tasks_count;
+    for (i = 0; i < pool->workers_count; ++i) {
+        worker = &pool->workers[i];
+        pthread_mutex_lock(&worker->lock);
+        worker->begin = tasks_count * i / pool->workers_count;
+        worker->end = tasks_count * (i + 1) / pool->workers_count;
+        pthread_mutex_unlock(&worker->lock);
+    }
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    hashids_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+/* free a pool */
+void
+hashids_pool_free(hashids_pool_t *pool)
+{
+    size_t i;
+
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i < pool->workers_count; ++i) {
+        if (pool->workers[i].pool) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+    }
+    for (i = 0; i < pool->workers_count; ++i) {
+        pthread_mutex_destroy(&pool->workers[i].lock);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    _hashids_free(pool);
+}
+
+/* create a pool of threads_count workers, the caller included */
+hashids_pool_t *
+hashids_pool_init(size_t threads_count)
+{
+    hashids_pool_t *result;
+    long online;
+    size_t i;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    /* as many as there are CPUs */
+    if (!threads_count) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_count = online > 0 ? (size_t)online : 1;
+    }
+
+    result = (hashids_pool_t *)_hashids_alloc(sizeof(hashids_pool_t)
+        + (threads_count - 1) * sizeof(struct hashids_pool_worker_s));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    pthread_mutex_init(&result->run_lock, NULL);
+    pthread_mutex_init(&result->lock, NULL);
+    pthread_cond_init(&result->start, NULL);
+    pthread_cond_init(&result->done, NULL);
+    result->workers_count = threads_count;
+    for (i = 0; i < threads_count; ++i) {
+        pthread_mutex_init(&result->workers[i].lock, NULL);
+        result->workers[i].index = i;
+    }
+
+    result->executor.run = hashids_pool_run;
+    result->executor.ctx = result;
+    result->executor.workers_count = threads_count;
+
+    for (i = 1; i < threads_count; ++i) {
+        result->workers[i].pool = result;
+        if (pthread_create(&result->workers[i].thread, NULL,
+            hashids_pool_thread, &result->workers[i]) != 0) {
+            result->workers[i].pool = NULL;
+            hashids_pool_free(result);
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+/* the executor to hand to the parallel functions */
+const hashids_executor_t *
+hashids_pool_executor(hashids_pool_t *pool)
+{
+    return &pool->executor;
+}
@@ -0,0 +1,321 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "hashids.h"
+
+/* shard count - a power of two */
+#define HASHIDS_REGISTRY_SHARDS 16u
+
+/* a shard: bucket chains, an LRU list and a lock */
+struct hashids_registry_shard_s {
+    pthread_mutex_t lock;
+    hashids_registry_entry_t **buckets;
+    size_t buckets_mask;
+
+    hashids_registry_entry_t *lru_head;
+    hashids_registry_entry_t *lru_tail;
+    size_t count;
+    size_t capacity;
+};
+
+/* the registry "object" */
+struct hashids_registry_s {
+    struct hashids_registry_shard_s shards[HASHIDS_REGISTRY_SHARDS];
+};
+
+/* mix a key part in, a word at a time */
+static inline unsigned long long
+hashids_registry_mix(unsigned long long hash, const char *str, size_t length)
+{
+    unsigned long long word;
+
+    for (; length >= sizeof(word); length -= sizeof(word)) {
+        memcpy(&word, str, sizeof(word));
+        str += sizeof(word);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+
+    word = 0;
+    memcpy(&word, str, length);
+    hash = (hash ^ word ^ ((unsigned long long)length << 56))
+        * 0x9E3779B97F4A7C15ull;
+
+    return hash ^ (hash >> 29);
+}
+
+/* hash of the whole key */
+static inline unsigned long long
+hashids_registry_hash(const char *salt, size_t salt_length,
+    size_t min_hash_length, const char *alphabet, size_t alphabet_length)
+{
+    unsigned long long hash = 0xCBF29CE484222325ull ^ min_hash_length;
+
+    hash = hashids_registry_mix(hash, salt, salt_length);
+    hash = hashids_registry_mix(hash, alphabet, alphabet_length);
+
+    /* the low bits pick the bucket, the high bits pick the shard */
+    return hash;
+}
+
+/* drop a reference, free the entry with the last one */
+static void
+hashids_registry_unref(hashids_registry_entry_t *entry)
+{
+    if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        hashids_free(entry->hashids);
+        _hashids_free(entry);
+    }
+}
+
+/* unlink from the LRU list (shard lock held) */
+static inline void
+hashids_registry_lru_unlink(struct hashids_registry_shard_s *shard,
+    hashids_registry_entry_t *entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        shard->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        shard->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+/* link at the LRU head (shard lock held) */
+static inline void
+hashids_registry_lru_push(struct hashids_registry_shard_s *shard,
+    hashids_registry_entry_t *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = shard->lru_head;
+    if (shard->lru_head) {
+        shard->lru_head->lru_prev = entry;
+    } else {
+        shard->lru_tail = entry;
+    }
+    shard->lru_head = entry;
+}
+
+/* find an entry and take a reference (shard lock held) */
+static hashids_registry_entry_t *
+hashids_registry_find(struct hashids_registry_shard_s *shard,
+    unsigned long long hash, const char *salt, size_t salt_length,
+    size_t min_hash_length, const char *alphabet, size_t alphabet_length)
+{
+    hashids_registry_entry_t *entry;
+
+    for (entry = shard->buckets[hash & shard->buckets_mask]; entry;
+        entry = entry->chain) {
+        if (entry->hash == hash
+            && entry->min_hash_length == min_hash_length
+            && entry->salt_length == salt_length
+            && entry->alphabet_length == alphabet_length
+            && memcmp(entry->key, salt, salt_length) == 0
+            && memcmp(entry->key + salt_length + 1, alphabet,
+                alphabet_length) == 0) {
+            /* most recently used goes first */
+            if (entry != shard->lru_head) {
+                hashids_registry_lru_unlink(shard, entry);
+                hashids_registry_lru_push(shard, entry);
+            }
+
+            __atomic_add_fetch(&entry->refs, 1, __ATOMIC_RELAXED);
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* evict the least recently used entry (shard lock held) */
+static void
+hashids_registry_evict(struct hashids_registry_shard_s *shard)
+{
+    hashids_registry_entry_t *entry = shard->lru_tail, **link;
+
+    for (link = &shard->buckets[entry->hash & shard->buckets_mask];
+        *link != entry; link = &(*link)->chain) {
+        /* empty */
+    }
+    *link = entry->chain;
+
+    hashids_registry_lru_unlink(shard, entry);
+    --shard->count;
+
+    /* in-flight users keep it alive */
+    hashids_registry_unref(entry);
+}
+
+/* "destructor" */
+void
+hashids_registry_free(hashids_registry_t *registry)
+{
+    struct hashids_registry_shard_s *shard;
+    size_t i;
+
+    if (!registry) {
+        return;
+    }
+
+    for (i = 0; i < HASHIDS_REGISTRY_SHARDS; ++i) {
+        shard = &registry->shards[i];
+        if (shard->buckets) {
+            while (shard->lru_tail) {
+                hashids_registry_evict(shard);
+            }
+            _hashids_free(shard->buckets);
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    _hashids_free(registry);
+}
+
+/* "constructor" */
+hashids_registry_t *
+hashids_registry_init(size_t capacity)
+{
+    hashids_registry_t *result;
+    struct hashids_registry_shard_s *shard;
+    size_t i, per_shard, buckets;
+
+    hashids_errno = HASHIDS_ERROR_OK;
+
+    result = (hashids_registry_t *)_hashids_alloc(sizeof(hashids_registry_t));
+    if (!result) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    /* split the capacity, keep chains short */
+    per_shard = (capacity + HASHIDS_REGISTRY_SHARDS - 1)
+        / HASHIDS_REGISTRY_SHARDS;
+    if (!per_shard) {
+        per_shard = 1;
+    }
+    for (buckets = 4; buckets < per_shard * 2; buckets <<= 1) {
+        /* empty */
+    }
+
+    for (i = 0; i < HASHIDS_REGISTRY_SHARDS; ++i) {
+        shard = &result->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = per_shard;
+        shard->buckets_mask = buckets - 1;
+        shard->buckets = (hashids_registry_entry_t **)_hashids_alloc(
+            buckets * sizeof(hashids_registry_entry_t *));
+        if (!shard->buckets) {
+            for (++i; i < HASHIDS_REGISTRY_SHARDS; ++i) {
+                pthread_mutex_init(&result->shards[i].lock, NULL);
+            }
+            hashids_registry_free(result);
+            hashids_errno = HASHIDS_ERROR_ALLOC;
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+/* get a shared instance, creating it on a miss */
+hashids_registry_entry_t *
+hashids_registry_acquire(hashids_registry_t *registry, const char *salt,
+    size_t min_hash_length, const char *alphabet)
+{
+    struct hashids_registry_shard_s *shard;
+    hashids_registry_entry_t *entry, *found;
+    unsigned long long hash;
+    size_t salt_length, alphabet_length;
+
+    if (!salt) {
+        salt = HASHIDS_DEFAULT_SALT;
+    }
+    if (!alphabet) {
+        alphabet = HASHIDS_DEFAULT_ALPHABET;
+    }
+
+    salt_length = strlen(salt);
+    alphabet_length = strlen(alphabet);
+    hash = hashids_registry_hash(salt, salt_length, min_hash_length,
+        alphabet, alphabet_length);
+    shard = &registry->shards[(hash >> 60) & (HASHIDS_REGISTRY_SHARDS - 1)];
+
+    /* hit */
+    pthread_mutex_lock(&shard->lock);
+    found = hashids_registry_find(shard, hash, salt, salt_length,
+        min_hash_length, alphabet, alphabet_length);
+    pthread_mutex_unlock(&shard->lock);
+    if (found) {
+        return found;
+    }
+
+    /* miss - build outside of the lock */
+    entry = (hashids_registry_entry_t *)_hashids_alloc(
+        sizeof(hashids_registry_entry_t) + salt_length + alphabet_length + 1);
+    if (!entry) {
+        hashids_errno = HASHIDS_ERROR_ALLOC;
+        return NULL;
+    }
+
+    /* shared & long-lived - worth the tables */
+    entry->hashids = hashids_init5(salt, min_hash_length, alphabet, NULL,
+        HASHIDS_TABLE_SHUFFLE | HASHIDS_TABLE_PAD);
+    if (!entry->hashids) {
+        _hashids_free(entry);
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->min_hash_length = min_hash_length;
+    entry->salt_length = salt_length;
+    entry->alphabet_length = alphabet_length;
+    memcpy(entry->key, salt, salt_length);
+    memcpy(entry->key + salt_length + 1, alphabet, alphabet_length);
+
+    /* one reference for the registry, one for the caller */
+    entry->refs = 2;
+
+    pthread_mutex_lock(&shard->lock);
+
+    /* somebody might have been faster */
+    found = hashids_registry_find(shard, hash, salt, salt_length,
+        min_hash_length, alphabet, alphabet_length);
+    if (found) {
+        pthread_mutex_unlock(&shard->lock);
+        hashids_free(entry->hashids);
+        _hashids_free(entry);
+        return found;
+    }
+
+    if (shard->count >= shard->capacity) {
+        hashids_registry_evict(shard);
+    }
+
+    entry->chain = shard->buckets[hash & shard->buckets_mask];
+    shard->buckets[hash & shard->buckets_mask] = entry;
+    hashids_registry_lru_push(shard, entry);
+    ++shard->count;
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return entry;
+}
+
+/* give back an instance obtained with hashids_registry_acquire() */
+void
+hashids_registry_release(hashids_registry_entry_t *entry)
+{
+    if (entry) {
+        hashids_registry_unref(entry);
+    }
+}
@@ -1,8 +1,11 @@
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "hashids.h"
 
@@ -200,6 +203,10 @@ struct testcase_t testcases[] = {
 
 char *failures[lengthof(testcases)];
 
+/* feature checks beyond the encode / decode samples */
+char *check_failures[256];
+size_t checks_count = 0, check_failures_count = 0;
+
 char *
 f(const char *fmt, ...)
 {
@@ -219,6 +226,1659 @@ f(const char *fmt, ...)
     return result;
 }
 
+void
+check(int ok, int line, const char *description)
+{
+    ++checks_count;
+    fputc(ok ? '.' : 'F', stdout);
+
+    if (!ok && check_failures_count < lengthof(check_failures) - 1) {
+        check_failures[check_failures_count++] = f("%s:%d: %s",
+            __FILE__, line, description);
+    }
+}
+
+void
+test_allocator(void)
+{
+    hashids_t *hashids;
+    hashids_arena_t arena;
+    char arena_buffer[4096], buffer[64];
+    size_t used;
+
+    hashids_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    hashids = hashids_init4("this is my salt", 0, HASHIDS_DEFAULT_ALPHABET,
+        &arena.allocator);
+    check(hashids != NULL, __LINE__, "hashids_init4() with an arena failed");
+    if (!hashids) {
+        return;
+    }
+    check(arena.used > 0, __LINE__, "arena was not used by hashids_init4()");
+
+    used = arena.used;
+    hashids_encode_v(hashids, buffer, 3, 1ull, 2ull, 3ull);
+    check(strcmp(buffer, "laHquq") == 0, __LINE__,
+        "hashids_encode_v() with an arena returned a wrong hash");
+    check(arena.used == used, __LINE__,
+        "hashids_encode_v() leaked arena memory");
+
+    hashids_free(hashids);
+    hashids_arena_reset(&arena);
+    check(arena.used == 0, __LINE__, "hashids_arena_reset() failed");
+
+    /* exhausted arenas fail cleanly */
+    hashids_arena_init(&arena, arena_buffer, 64);
+    hashids = hashids_init4("", 0, HASHIDS_DEFAULT_ALPHABET, &arena.allocator);
+    check(!hashids && hashids_errno == HASHIDS_ERROR_ALLOC, __LINE__,
+        "hashids_init4() did not fail with an exhausted arena");
+}
+
+void
+test_init(void)
+{
+    hashids_t *hashids;
+    char buffer[64];
+    unsigned int tables;
+
+    hashids = hashids_init3("", 0, "abcdefghijklmno");
+    check(!hashids && hashids_errno == HASHIDS_ERROR_ALPHABET_LENGTH,
+        __LINE__, "hashids_init3() accepted a short alphabet");
+    hashids = hashids_init3("", 0, "aabbccddeeffgghhiijjkkllmmnnoo");
+    check(!hashids && hashids_errno == HASHIDS_ERROR_ALPHABET_LENGTH,
+        __LINE__, "hashids_init3() did not deduplicate the alphabet");
+    hashids = hashids_init3("", 0, "abcdefghijklmnop qrstuvwxyz");
+    check(!hashids && hashids_errno == HASHIDS_ERROR_ALPHABET_SPACE,
+        __LINE__, "hashids_init3() accepted a space in the alphabet");
+    hashids = hashids_init3("", 0, "abcdefghijklmnop\tqrstuvwxyz");
+    check(!hashids && hashids_errno == HASHIDS_ERROR_ALPHABET_SPACE,
+        __LINE__, "hashids_init3() accepted a tab in the alphabet");
+
+    hashids = hashids_init3("", 0, "Uutsihfc" HASHIDS_DEFAULT_ALPHABET);
+    check(hashids && hashids->alphabet_length == 44
+            && hashids->separators_count == 14, __LINE__,
+        "hashids_init3() split separators wrong");
+    hashids_free(hashids);
+
+    /* with a long salt, the per-number shuffle with & without its table */
+    for (tables = 0; tables <= HASHIDS_TABLE_SHUFFLE; ++tables) {
+        hashids = hashids_init5("0123456789abcdef0123456789abcdef"
+            "0123456789abcdef0123456789abcdef", 0, HASHIDS_DEFAULT_ALPHABET,
+            NULL, tables);
+        check(hashids && !hashids->shuffle_steps == !tables, __LINE__,
+            "hashids_init5() built the wrong tables");
+        hashids_encode_v(hashids, buffer, 3, 1ull, 2ull, 3ull);
+        check(strcmp(buffer, "XNC7FQ") == 0, __LINE__,
+            "hashids_encode() with a long salt failed");
+        hashids_encode_one(hashids, buffer, 1234567890123ull);
+        check(strcmp(buffer, "VY3VRAD2l") == 0, __LINE__,
+            "hashids_encode_one() with a long salt failed");
+        hashids_free(hashids);
+    }
+}
+
+void
+test_derive(void)
+{
+    hashids_t *template, *hashids;
+    struct testcase_t *testcase;
+    char buffer[2048];
+    int ok;
+
+    /* derive every sample from an unsalted template, every other one with
+       the tables it inherits */
+    for (testcase = testcases; testcase->salt; ++testcase) {
+        template = hashids_init5("not the salt", testcase->min_hash_length,
+            testcase->alphabet, NULL,
+            (testcase - testcases) % 2
+                ? HASHIDS_TABLE_SHUFFLE | HASHIDS_TABLE_PAD : 0);
+        hashids = template ? hashids_derive(template, testcase->salt) : NULL;
+
+        ok = hashids != NULL && hashids->tables == template->tables;
+        if (ok) {
+            hashids_encode(hashids, buffer, testcase->numbers_count,
+                testcase->numbers);
+            ok = strcmp(buffer, testcase->expected_hash) == 0;
+        }
+        check(ok, testcase->line, "hashids_derive() encoded differently");
+
+        hashids_free(hashids);
+        hashids_free(template);
+    }
+}
+
+void *
+registry_worker(void *arg)
+{
+    hashids_registry_t *registry = (hashids_registry_t *)arg;
+    hashids_registry_entry_t *entry;
+    char salt[16], buffer[64];
+    size_t i;
+
+    for (i = 0; i < 2000; ++i) {
+        snprintf(salt, sizeof(salt), "%lu", (unsigned long)(i % 64));
+        entry = hashids_registry_acquire(registry, i % 2 ? "" : salt, 0,
+            HASHIDS_DEFAULT_ALPHABET);
+        if (!entry) {
+            return (void *)1;
+        }
+        hashids_encode_one(entry->hashids, buffer, 1);
+        if (i % 2 && strcmp(buffer, "jR") != 0) {
+            hashids_registry_release(entry);
+            return (void *)1;
+        }
+        hashids_registry_release(entry);
+    }
+
+    return NULL;
+}
+
+void
+test_registry(void)
+{
+    hashids_registry_t *registry;
+    hashids_registry_entry_t *a, *b, *c;
+    pthread_t threads[4];
+    void *result;
+    char buffer[64], salt[16];
+    size_t i, failed;
+
+    registry = hashids_registry_init(16);
+    if (!registry) {
+        check(0, __LINE__, "hashids_registry_init() failed");
+        return;
+    }
+
+    a = hashids_registry_acquire(registry, "this is my salt", 0,
+        HASHIDS_DEFAULT_ALPHABET);
+    b = hashids_registry_acquire(registry, "this is my salt", 0,
+        HASHIDS_DEFAULT_ALPHABET);
+    c = hashids_registry_acquire(registry, "this is my salt", 8,
+        HASHIDS_DEFAULT_ALPHABET);
+    check(a && a == b, __LINE__,
+        "hashids_registry_acquire() did not share an instance");
+    check(c && c != a, __LINE__,
+        "hashids_registry_acquire() ignored min_hash_length");
+    hashids_registry_release(b);
+    hashids_registry_release(c);
+
+    /* flood the registry - a held entry stays usable after eviction */
+    for (i = 0; i < 256; ++i) {
+        snprintf(salt, sizeof(salt), "flood %lu", (unsigned long)i);
+        hashids_registry_release(hashids_registry_acquire(registry, salt, 0,
+            HASHIDS_DEFAULT_ALPHABET));
+    }
+    hashids_encode_one(a->hashids, buffer, 1);
+    check(strcmp(buffer, "NV") == 0, __LINE__,
+        "an evicted registry entry became unusable");
+    hashids_registry_release(a);
+
+    /* invalid alphabets are reported, not cached */
+    a = hashids_registry_acquire(registry, "", 0, "abc");
+    check(!a && hashids_errno == HASHIDS_ERROR_ALPHABET_LENGTH, __LINE__,
+        "hashids_registry_acquire() accepted a short alphabet");
+
+    /* concurrent acquire / release */
+    for (i = 0; i < lengthof(threads); ++i) {
+        pthread_create(&threads[i], NULL, registry_worker, registry);
+    }
+    for (i = 0, failed = 0; i < lengthof(threads); ++i) {
+        pthread_join(threads[i], &result);
+        failed += result != NULL;
+    }
+    check(!failed, __LINE__, "concurrent registry use failed");
+
+    hashids_registry_free(registry);
+}
+
+void
+test_file(void)
+{
+    hashids_t *instances[8], *hashids, *derived, crafted;
+    hashids_file_t *file;
+    char path[] = "/tmp/hashids-test-XXXXXX", expected[2048], buffer[2048];
+    struct testcase_t *testcase;
+    size_t i, count;
+    FILE *fp;
+    int fd, ok, ch;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        check(0, __LINE__, "mkstemp() failed");
+        return;
+    }
+    close(fd);
+
+    /* a handful of differently shaped instances, half with tables */
+    for (i = 0, testcase = testcases; i < lengthof(instances); ++i) {
+        instances[i] = hashids_init5(testcase->salt,
+            testcase->min_hash_length, testcase->alphabet, NULL,
+            i % 2 ? HASHIDS_TABLE_SHUFFLE | HASHIDS_TABLE_PAD : 0);
+        testcase += 7;
+    }
+
+    check(hashids_file_save(path, instances, lengthof(instances))
+        == HASHIDS_ERROR_OK, __LINE__, "hashids_file_save() failed");
+
+    file = hashids_file_open(path);
+    check(file && hashids_file_count(file) == lengthof(instances), __LINE__,
+        "hashids_file_open() failed");
+    if (file) {
+        for (i = 0, ok = 1; i < lengthof(instances); ++i) {
+            hashids = hashids_file_get(file, i);
+            ok = ok && !hashids->shuffle_steps == !instances[i]->shuffle_steps
+                && !hashids->pad_templates == !instances[i]->pad_templates;
+            for (count = 1; count < 4; ++count) {
+                hashids_encode(instances[i], expected, count,
+                    testcases[i].numbers);
+                hashids_encode(hashids, buffer, count, testcases[i].numbers);
+                ok = ok && strcmp(expected, buffer) == 0;
+            }
+        }
+        check(ok, __LINE__, "mapped instances encoded differently");
+
+        derived = hashids_derive(hashids_file_get(file, 0), "this is my salt");
+        hashids_encode_one(derived, buffer, 1);
+        check(strcmp(buffer, "NV") == 0, __LINE__,
+            "hashids_derive() from a mapped instance failed");
+        hashids_free(derived);
+
+        hashids_file_close(file);
+    }
+
+    /* flip a byte - the checksum must catch it */
+    fp = fopen(path, "r+b");
+    if (fp) {
+        fseek(fp, -3, SEEK_END);
+        ch = fgetc(fp);
+        fseek(fp, -3, SEEK_END);
+        fputc(ch ^ 0x20, fp);
+        fclose(fp);
+    }
+    file = hashids_file_open(path);
+    check(!file && hashids_errno == HASHIDS_ERROR_INVALID_FILE, __LINE__,
+        "hashids_file_open() accepted a corrupted file");
+    hashids_file_close(file);
+
+    /* records setup could never make, saved with a proper checksum - a
+       1-character alphabet, guards taken from the alphabet */
+    for (i = 0; i < 2; ++i) {
+        crafted = *instances[0];
+        if (i == 0) {
+            crafted.alphabet += crafted.alphabet_length - 1;
+            crafted.alphabet_length = 1;
+        } else {
+            crafted.guards = crafted.alphabet + crafted.alphabet_length
+                - crafted.guards_count;
+        }
+        hashids = &crafted;
+        file = hashids_file_save(path, &hashids, 1) == HASHIDS_ERROR_OK
+            ? hashids_file_open(path) : NULL;
+        check(!file && hashids_errno == HASHIDS_ERROR_INVALID_FILE, __LINE__,
+            "hashids_file_open() accepted an impossible record");
+        hashids_file_close(file);
+    }
+
+    unlink(path);
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void *
+counting_alloc(void *ctx, size_t size)
+{
+    ++*(size_t *)ctx;
+    return calloc(size, 1);
+}
+
+void
+counting_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+void
+test_convenience(void)
+{
+    hashids_t *hashids;
+    size_t allocations = 0;
+    hashids_allocator_t allocator = {counting_alloc, counting_free, NULL};
+    unsigned long long numbers[4], seed = 5;
+    char buffer[128], output[32];
+    size_t i, j;
+    int ok;
+
+    allocator.ctx = &allocations;
+    hashids = hashids_init4("", 0, HASHIDS_DEFAULT_ALPHABET, &allocator);
+    if (!hashids) {
+        check(0, __LINE__, "hashids_init4() failed");
+        return;
+    }
+    allocations = 0;
+
+    check(hashids_estimate_encoded_size_v(hashids, 5,
+            1ull, 2ull, 3ull, 4ull, 5ull) == 12,
+        __LINE__, "hashids_estimate_encoded_size_v() returned a wrong size");
+    hashids_encode_v(hashids, buffer, 5, 1ull, 2ull, 3ull, 4ull, 5ull);
+    check(strcmp(buffer, "ADf9h9i0sQ") == 0, __LINE__,
+        "hashids_encode_v() returned a wrong hash");
+    hashids_encode_hex(hashids, buffer, "C0FFEE");
+    check(strcmp(buffer, "k7AVov") == 0, __LINE__,
+        "hashids_encode_hex() returned a wrong hash");
+    check(hashids_decode_hex(hashids, buffer, output) == 1
+            && strcmp(output, "C0FFEE") == 0,
+        __LINE__, "hashids_decode_hex() returned a wrong hex string");
+    hashids_encode_hex(hashids, buffer, "000f");
+    check(hashids_decode_hex(hashids, buffer, output) == 1
+            && strcmp(output, "000F") == 0,
+        __LINE__, "hashids_encode_hex() lost leading zeroes");
+    check(allocations == 0, __LINE__,
+        "variadic / hex helpers touched the allocator");
+
+    /* every number may take a digit more than its rounded-down bits say */
+    hashids_free(hashids);
+    hashids = hashids_init3("salt!", 0, "abcdefghijklmnopqrstuvwxyz");
+    for (i = 0, ok = 1; hashids && i < 1000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        for (j = 0; j < lengthof(numbers); ++j) {
+            numbers[j] = (seed ^ seed >> (j * 13 + 1)) >> (seed >> 58);
+        }
+        ok = ok && hashids_estimate_encoded_size(hashids, lengthof(numbers),
+            numbers) > hashids_encode(hashids, buffer, lengthof(numbers),
+                numbers);
+    }
+    check(ok, __LINE__, "hashids_estimate_encoded_size() came up short");
+
+    hashids_free(hashids);
+}
+
+void
+test_big(void)
+{
+    hashids_t *hashids, *padded, *instance;
+    static const char *short_hex[] = {"", "0", "C0FFEE", "000F",
+        "123456789ABCDE"};
+    unsigned char bytes[300], decoded[300], small[2] = {0xAB, 0xCD};
+    char hex[1001], output[1001], buffer[1024], expected[65],
+        reencoded[128];
+    unsigned long long seed = 42;
+    size_t i, j, length;
+    int ok;
+
+    hashids = hashids_init("this is my salt");
+    padded = hashids_init2("this is my salt", 64);
+    if (!hashids || !padded) {
+        check(0, __LINE__, "hashids_init() failed");
+        hashids_free(hashids);
+        hashids_free(padded);
+        return;
+    }
+
+    /* up to 64 bits the big path agrees with the regular one */
+    for (i = 0, ok = 1; i < lengthof(short_hex); ++i) {
+        hashids_encode_hex(padded, expected, short_hex[i]);
+        hashids_encode_hex_big(padded, buffer, short_hex[i]);
+        ok = ok && strcmp(buffer, expected) == 0;
+        ok = ok && hashids_decode_hex_big(padded, buffer, output,
+            sizeof(output)) == strlen(short_hex[i])
+            && strcmp(output, short_hex[i]) == 0;
+    }
+    check(ok, __LINE__, "hashids_encode_hex_big() disagrees with "
+        "hashids_encode_hex()");
+    hashids_encode_one(hashids, expected, 0x1ABCDull);
+    hashids_encode_bytes(hashids, buffer, small, sizeof(small));
+    check(strcmp(buffer, expected) == 0, __LINE__,
+        "hashids_encode_bytes() disagrees with hashids_encode_one()");
+
+    /* 128 bits, 4000 bits & everything in between */
+    for (i = 0; i < sizeof(hex) - 1; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        hex[i] = "0123456789ABCDEF"[seed >> 60];
+        bytes[i % sizeof(bytes)] = (unsigned char)(seed >> 52);
+    }
+    for (length = 0, ok = 1; length < sizeof(hex); length += 31) {
+        hex[length] = '\0';
+        ok = ok && hashids_encode_hex_big(padded, NULL, hex)
+            > hashids_encode_hex_big(padded, buffer, hex);
+        ok = ok && hashids_decode_hex_big(padded, buffer, output,
+            sizeof(output)) == length && strcmp(output, hex) == 0;
+        hex[length] = "0123456789ABCDEF"[length % 16];
+    }
+    check(ok, __LINE__, "hashids_decode_hex_big() did not round-trip");
+
+    for (length = 0, ok = 1; length <= sizeof(bytes); length += 16) {
+        ok = ok && hashids_encode_bytes(hashids, NULL, bytes, length)
+            > hashids_encode_bytes(hashids, buffer, bytes, length);
+        ok = ok && hashids_decode_bytes(hashids, buffer, decoded,
+            sizeof(decoded)) == length
+            && memcmp(decoded, bytes, length) == 0;
+    }
+    check(ok, __LINE__, "hashids_decode_bytes() did not round-trip");
+
+    /* every character other than a hex digit is refused */
+    strcpy(hex, "0123456789abcdef0123456789ABCDEF01");
+    for (i = 1, ok = 1; i < 256; ++i) {
+        hex[i % 34] = (char)i;
+        hashids_errno = HASHIDS_ERROR_OK;
+        ok = ok && !hashids_encode_hex_big(hashids, buffer, hex)
+            == !isxdigit((int)i)
+            && hashids_errno == (isxdigit((int)i)
+                ? HASHIDS_ERROR_OK : HASHIDS_ERROR_INVALID_NUMBER);
+        hex[i % 34] = '0';
+    }
+    check(ok, __LINE__, "hashids_encode_hex_big() accepted a non-hex digit");
+    check(!hashids_encode_hex(hashids, buffer, "C0FFEE ")
+            && hashids_errno == HASHIDS_ERROR_INVALID_NUMBER
+            && !hashids_encode_hex(hashids, buffer, "0123456789ABCDEF")
+            && hashids_errno == HASHIDS_ERROR_INVALID_NUMBER,
+        __LINE__, "hashids_encode_hex() accepted an invalid hex string");
+
+    /* a short output is left alone, the length is still reported */
+    hashids_encode_hex_big(hashids, buffer,
+        "0123456789ABCDEF0123456789ABCDEF");
+    strcpy(output, "untouched");
+    check(hashids_decode_hex_big(hashids, buffer, output, 32) == 32
+            && strcmp(output, "untouched") == 0,
+        __LINE__, "hashids_decode_hex_big() overran a short output");
+
+    /* multiple numbers are not a big number */
+    hashids_encode_v(hashids, buffer, 2, 1ull, 2ull);
+    check(hashids_decode_hex_big(hashids, buffer, output, sizeof(output)) == 0
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH,
+        __LINE__, "hashids_decode_hex_big() accepted several numbers");
+
+    /* only the hash itself decodes - a trailing guard, another lottery or
+       a changed character is refused unless it makes another valid hash */
+    for (i = 0, ok = 1; i < 600; ++i) {
+        instance = i % 3 == 1 || i % 2 ? hashids : padded;
+        for (j = 0; j < 32; ++j) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            hex[j] = "0123456789ABCDEF"[seed >> 60];
+        }
+        hex[j] = '\0';
+        length = hashids_encode_hex_big(instance, buffer, hex);
+        if (i % 3 == 0) {
+            buffer[length] = instance->guards[seed % instance->guards_count];
+            buffer[length + 1] = '\0';
+        } else if (i % 3 == 1) {
+            buffer[0] = instance->alphabet[(strchr(instance->alphabet,
+                buffer[0]) - instance->alphabet + 1 + seed % 7)
+                % instance->alphabet_length];
+        } else {
+            buffer[seed % length] = instance->alphabet[(seed >> 32)
+                % instance->alphabet_length];
+        }
+        if (hashids_decode_hex_big(instance, buffer, output, sizeof(output))) {
+            hashids_encode_hex_big(instance, reencoded, output);
+            ok = ok && i % 3 != 0 && strcmp(reencoded, buffer) == 0;
+        } else {
+            ok = ok && hashids_errno == HASHIDS_ERROR_INVALID_HASH;
+        }
+        ok = ok && (i % 3 != 0 || (!hashids_decode_bytes(instance, buffer,
+            decoded, sizeof(decoded))
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH));
+    }
+    check(ok, __LINE__, "hashids_decode_hex_big() accepted a mutated hash");
+
+    hashids_free(hashids);
+    hashids_free(padded);
+}
+
+void
+test_uuid(void)
+{
+    hashids_t *hashids, *padded, *small, *instance;
+    unsigned char uuids[64 * HASHIDS_UUID_SIZE],
+        decoded[64 * HASHIDS_UUID_SIZE], uuid[HASHIDS_UUID_SIZE] = {0};
+    char batch[64 * 80], buffer[HASHIDS_UUID_BUFFER_SIZE],
+        expected[HASHIDS_UUID_BUFFER_SIZE];
+    static const char *small_alphabets[] = {"0123456789abcdef",
+        "cfhistuCFHISTUab"};
+    unsigned long long seed = 7;
+    size_t i, j, length;
+    int ok;
+
+    hashids = hashids_init("this is my salt");
+    padded = hashids_init2("this is my salt", 72);
+    if (!hashids || !padded) {
+        check(0, __LINE__, "hashids_init() failed");
+        hashids_free(hashids);
+        hashids_free(padded);
+        return;
+    }
+
+    for (i = 0; i < sizeof(uuids); ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uuids[i] = (unsigned char)(seed >> 56);
+    }
+
+    /* a UUID is a plain 128-bit number */
+    uuid[15] = 42;
+    hashids_encode_one(hashids, expected, 42);
+    hashids_encode_uuid(hashids, buffer, uuid);
+    check(strcmp(buffer, expected) == 0, __LINE__,
+        "hashids_encode_uuid() disagrees with hashids_encode_one()");
+    uuid[0] = 0x01;
+    memcpy(uuid + 1, uuids, HASHIDS_UUID_SIZE - 1);
+    hashids_encode_bytes(padded, expected, uuids, HASHIDS_UUID_SIZE - 1);
+    hashids_encode_uuid(padded, buffer, uuid);
+    check(strcmp(buffer, expected) == 0, __LINE__,
+        "hashids_encode_uuid() disagrees with hashids_encode_bytes()");
+    /* lottery, 26 digits (5 bits each at least) & NUL */
+    check(hashids_encode_uuid(hashids, NULL, uuid) == 28, __LINE__,
+        "hashids_encode_uuid() returned a wrong size");
+
+    /* batches agree with single calls & round-trip */
+    check(hashids_encode_uuid_batch(padded, batch, 80, uuids, 64) == 64,
+        __LINE__, "hashids_encode_uuid_batch() failed");
+    for (i = 0, ok = 1; i < 64; ++i) {
+        ok = ok && hashids_encode_uuid(padded, buffer,
+            uuids + i * HASHIDS_UUID_SIZE) == 72
+            && strcmp(buffer, batch + i * 80) == 0
+            && hashids_decode_uuid(padded, buffer, uuid) == 1
+            && memcmp(uuid, uuids + i * HASHIDS_UUID_SIZE,
+                HASHIDS_UUID_SIZE) == 0;
+    }
+    check(ok, __LINE__, "hashids_encode_uuid_batch() disagrees with "
+        "hashids_encode_uuid()");
+    check(hashids_decode_uuid_batch(padded, batch, 80, 64, decoded) == 64
+            && memcmp(decoded, uuids, sizeof(uuids)) == 0,
+        __LINE__, "hashids_decode_uuid_batch() did not round-trip");
+    check(hashids_encode_uuid_batch(padded, batch, 72, uuids, 64) == 0,
+        __LINE__, "hashids_encode_uuid_batch() accepted a short stride");
+
+    /* decoding stops at the first bad slot */
+    hashids_encode_uuid_batch(hashids, batch, HASHIDS_UUID_BUFFER_SIZE,
+        uuids, 4);
+    hashids_encode_bytes(hashids, batch + 2 * HASHIDS_UUID_BUFFER_SIZE,
+        uuids, HASHIDS_UUID_SIZE);
+    check(hashids_decode_uuid_batch(hashids, batch, HASHIDS_UUID_BUFFER_SIZE,
+            4, decoded) == 2
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH,
+        __LINE__, "hashids_decode_uuid_batch() accepted a 129-bit number");
+
+    /* only the hash itself decodes - a trailing guard, another lottery or
+       a changed character is refused unless it makes another valid hash */
+    for (i = 0, ok = 1; i < 64 * 3; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        instance = i % 3 == 1 || i % 2 ? hashids : padded;
+        length = hashids_encode_uuid(instance, buffer,
+            uuids + i % 64 * HASHIDS_UUID_SIZE);
+        if (i % 3 == 0) {
+            batch[0] = instance->guards[seed % instance->guards_count];
+            batch[1] = '\0';
+            strcat(buffer, batch);
+        } else if (i % 3 == 1) {
+            buffer[0] = instance->alphabet[(strchr(instance->alphabet,
+                buffer[0]) - instance->alphabet + 1 + seed % 7)
+                % instance->alphabet_length];
+        } else {
+            buffer[seed % length] = instance->alphabet[(seed >> 32)
+                % instance->alphabet_length];
+        }
+        if (hashids_decode_uuid(instance, buffer, uuid)) {
+            hashids_encode_uuid(instance, expected, uuid);
+            ok = ok && i % 3 != 0 && strcmp(expected, buffer) == 0;
+        } else {
+            ok = ok && hashids_errno == HASHIDS_ERROR_INVALID_HASH;
+        }
+    }
+    check(ok, __LINE__, "hashids_decode_uuid() accepted a mutated hash");
+
+    /* a batch stops at the first of them */
+    hashids_encode_uuid_batch(padded, batch, 80, uuids, 4);
+    strcat(batch + 80, "x");
+    check(hashids_decode_uuid_batch(padded, batch, 80, 4, decoded) == 1
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH,
+        __LINE__, "hashids_decode_uuid_batch() accepted a trailing character");
+
+    /* HASHIDS_UUID_BUFFER_SIZE fits even a 2-symbol alphabet */
+    for (j = 0; j < lengthof(small_alphabets); ++j) {
+        small = hashids_init3("this is my salt", 0, small_alphabets[j]);
+        memset(uuid, 0xFF, HASHIDS_UUID_SIZE);
+        ok = small && hashids_encode_uuid(small, NULL, uuid)
+            <= HASHIDS_UUID_BUFFER_SIZE
+            && hashids_encode_uuid(small, buffer, uuid)
+                < HASHIDS_UUID_BUFFER_SIZE
+            && hashids_decode_uuid(small, buffer, decoded) == 1
+            && memcmp(decoded, uuid, HASHIDS_UUID_SIZE) == 0
+            && hashids_encode_uuid_batch(small, batch,
+                HASHIDS_UUID_BUFFER_SIZE, uuids, 8) == 8
+            && hashids_decode_uuid_batch(small, batch,
+                HASHIDS_UUID_BUFFER_SIZE, 8, decoded) == 8
+            && memcmp(decoded, uuids, 8 * HASHIDS_UUID_SIZE) == 0;
+        check(ok, __LINE__, "HASHIDS_UUID_BUFFER_SIZE is too small");
+        hashids_free(small);
+    }
+
+    hashids_free(hashids);
+    hashids_free(padded);
+}
+
+void
+test_batch(void)
+{
+    hashids_t *instances[4];
+    unsigned long long numbers[61], decoded[61], safe[2], seed = 11;
+    unsigned char valid[61];
+    char batch[61 * 80], buffer[80];
+    size_t i, j, count, length;
+    int ok;
+
+    instances[0] = hashids_init("this is my salt");
+    instances[1] = hashids_init2("this is my salt", 24);
+    instances[2] = hashids_init3("this is my salt", 0, "0123456789abcdef");
+    instances[3] = hashids_init3("", 0, "abcdefghijklmnopqrstuvwxyz"
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890!#$%&()*+,-./:;<=>?@[]^_{|}~");
+
+    /* small, huge & everything in between - and a partial last iteration */
+    for (i = 0; i < lengthof(numbers); ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = seed >> (i % 64);
+    }
+    numbers[0] = 0;
+    numbers[1] = 18446744073709551615ull;
+
+    for (j = 0; j < lengthof(instances); ++j) {
+        if (!instances[j]) {
+            check(0, __LINE__, "hashids_init3() failed");
+            continue;
+        }
+
+        check(hashids_encode_one_batch(instances[j], batch, 80, numbers,
+                lengthof(numbers)) == lengthof(numbers),
+            __LINE__, "hashids_encode_one_batch() failed");
+        for (i = 0, ok = 1; i < lengthof(numbers); ++i) {
+            hashids_encode_one(instances[j], buffer, numbers[i]);
+            ok = ok && strcmp(buffer, batch + i * 80) == 0;
+        }
+        check(ok, __LINE__, "hashids_encode_one_batch() disagrees with "
+            "hashids_encode_one()");
+
+        check(hashids_decode_one_batch(instances[j], batch, 80,
+                lengthof(numbers), decoded, valid) == lengthof(numbers)
+            && memcmp(decoded, numbers, sizeof(numbers)) == 0,
+            __LINE__, "hashids_decode_one_batch() failed");
+
+        /* past 64 bits or a leading zero, empty, separators, two numbers */
+        length = strlen(batch + 1 * 80);
+        batch[1 * 80 + length] = batch[1 * 80 + length - 1];
+        batch[1 * 80 + length + 1] = '\0';
+        batch[3 * 80] = '\0';
+        batch[5 * 80] = instances[j]->separators[0];
+        hashids_encode_v(instances[j], batch + 7 * 80, 2, 1ull, 2ull);
+        batch[11 * 80 + 1] = '\0';
+        strcat(batch + 13 * 80, "~");
+
+        count = hashids_decode_one_batch(instances[j], batch, 80,
+            lengthof(numbers), decoded, valid);
+        for (i = 0, ok = 1; i < lengthof(numbers); ++i) {
+            ok = ok && valid[i] == (hashids_decode_safe(instances[j],
+                    batch + i * 80, safe, lengthof(safe)) == 1)
+                && decoded[i] == (valid[i] ? safe[0] : 0);
+            count -= valid[i];
+        }
+        check(ok && !count && !valid[1] && !valid[7], __LINE__,
+            "hashids_decode_one_batch() disagrees with hashids_decode_safe()");
+    }
+
+    check(hashids_encode_one_batch(instances[1], batch, 24, numbers,
+            lengthof(numbers)) == 0,
+        __LINE__, "hashids_encode_one_batch() accepted a short stride");
+
+    for (j = 0; j < lengthof(instances); ++j) {
+        hashids_free(instances[j]);
+    }
+}
+
+/* a caller-supplied executor - backwards, spread over three workers */
+void
+reverse_run(void *ctx, void (*task)(void *arg, size_t index, size_t worker),
+    void *arg, size_t tasks_count)
+{
+    size_t i;
+
+    for (i = tasks_count; i--; /* empty */) {
+        task(arg, i, i % 3);
+    }
+    *(size_t *)ctx += tasks_count;
+}
+
+void
+test_parallel(void)
+{
+    hashids_t *hashids;
+    hashids_pool_t *pool;
+    hashids_executor_t reverse;
+    const hashids_executor_t *executors[3];
+    unsigned long long *numbers, *decoded, seed = 7;
+    unsigned char *valid;
+    char *expected, *batch;
+    size_t i, j, count = 10000, ran = 0;
+    int ok;
+
+    hashids = hashids_init2("this is my salt", 16);
+    pool = hashids_pool_init(4);
+    numbers = (unsigned long long *)malloc(count * sizeof(*numbers));
+    decoded = (unsigned long long *)malloc(count * sizeof(*decoded));
+    valid = (unsigned char *)malloc(count);
+    expected = (char *)malloc(count * 32);
+    batch = (char *)malloc(count * 32);
+    if (!hashids || !pool || !numbers || !decoded || !valid || !expected
+        || !batch) {
+        check(0, __LINE__, "test_parallel() setup failed");
+        goto cleanup;
+    }
+
+    for (i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        numbers[i] = seed >> (i % 64);
+    }
+    memset(expected, 0, count * 32);
+    hashids_encode_one_batch(hashids, expected, 32, numbers, count);
+
+    reverse.run = reverse_run;
+    reverse.ctx = &ran;
+    reverse.workers_count = 3;
+    executors[0] = hashids_pool_executor(pool);
+    executors[1] = &reverse;
+    executors[2] = NULL;
+
+    for (j = 0; j < lengthof(executors); ++j) {
+        memset(batch, 0, count * 32);
+        check(hashids_encode_one_parallel(hashids, batch, 32, numbers, count,
+                executors[j]) == count
+            && memcmp(batch, expected, count * 32) == 0,
+            __LINE__, "hashids_encode_one_parallel() failed");
+
+        /* one bad slot per chunk */
+        for (i = 0; i < count; i += 1000) {
+            batch[i * 32] = '\0';
+        }
+        check(hashids_decode_one_parallel(hashids, batch, 32, count, decoded,
+                valid, executors[j]) == count - 10,
+            __LINE__, "hashids_decode_one_parallel() failed");
+        for (i = 0, ok = 1; i < count; ++i) {
+            ok = ok && valid[i] == (i % 1000 != 0)
+                && decoded[i] == (valid[i] ? numbers[i] : 0);
+        }
+        check(ok, __LINE__, "hashids_decode_one_parallel() disagrees with "
+            "hashids_decode_one_batch()");
+    }
+    check(ran == 20, __LINE__, "a caller-supplied executor was not used");
+
+cleanup:
+    free(batch);
+    free(expected);
+    free(valid);
+    free(decoded);
+    free(numbers);
+    hashids_pool_free(pool);
+    hashids_free(hashids);
+}
+
+void *
+memo_worker(void *arg)
+{
+    hashids_memo_t *memo = (hashids_memo_t *)arg;
+    unsigned long long numbers[2], decoded[2];
+    char buffer[64], expected[64];
+    hashids_t *hashids;
+    size_t i;
+
+    hashids = hashids_init("this is my salt");
+    if (!hashids) {
+        return (void *)1;
+    }
+
+    /* a small working set over a smaller memo - plenty of evictions */
+    for (i = 0; i < 4000; ++i) {
+        numbers[0] = i % 97;
+        numbers[1] = i % 89;
+        hashids_encode(hashids, expected, 2, numbers);
+        if (hashids_memo_encode(memo, buffer, 2, numbers) != strlen(expected)
+            || strcmp(buffer, expected) != 0
+            || hashids_memo_decode(memo, expected, decoded, 2) != 2
+            || decoded[0] != numbers[0] || decoded[1] != numbers[1]) {
+            hashids_free(hashids);
+            return (void *)1;
+        }
+    }
+
+    hashids_free(hashids);
+    return NULL;
+}
+
+void
+test_memo(void)
+{
+    hashids_t *hashids;
+    hashids_memo_t *memo;
+    hashids_memo_stats_t stats;
+    unsigned long long numbers[5] = {1ull, 2ull, 3ull, 4ull, 5ull},
+        batch_numbers[100], decoded[100], safe[2];
+    unsigned char valid[100];
+    char buffer[64], expected[64], batch[100 * 32], expected_batch[100 * 32];
+    pthread_t threads[4];
+    void *result;
+    size_t i, failed;
+    int ok;
+
+    hashids = hashids_init("this is my salt");
+    memo = hashids ? hashids_memo_init(hashids, 64) : NULL;
+    if (!memo) {
+        check(0, __LINE__, "hashids_memo_init() failed");
+        hashids_free(hashids);
+        return;
+    }
+
+    /* a miss, then a hit - both ways */
+    for (i = 0, ok = 1; i < 2; ++i) {
+        ok = ok && hashids_memo_encode(memo, buffer, 3, numbers) == 6
+            && strcmp(buffer, "laHquq") == 0;
+    }
+    ok = ok && hashids_memo_decode(memo, "laHquq", decoded, 3) == 3
+        && decoded[0] == 1 && decoded[1] == 2 && decoded[2] == 3;
+    ok = ok && !hashids_memo_decode(memo, "laHquq", decoded, 2)
+        && hashids_errno == HASHIDS_ERROR_INVALID_HASH;
+    hashids_memo_stats(memo, &stats);
+    check(ok && stats.encode_hits == 1 && stats.encode_misses == 1
+        && stats.decode_hits == 2 && !stats.decode_misses,
+        __LINE__, "hashids_memo_encode() & hashids_memo_decode() failed");
+
+    /* too many numbers, non-canonical & invalid hashes go through */
+    hashids_encode(hashids, expected, 5, numbers);
+    check(hashids_memo_encode(memo, buffer, 5, numbers) == strlen(expected)
+        && strcmp(buffer, expected) == 0
+        && !hashids_memo_decode(memo, "laHquqa", decoded, 3)
+        && !hashids_memo_decode(memo, "", decoded, 3),
+        __LINE__, "hashids_memo_decode() accepted an invalid hash");
+
+    /* batches with repeats, and a hash that isn't */
+    for (i = 0; i < lengthof(batch_numbers); ++i) {
+        batch_numbers[i] = (i * i) % 7 * 1000003ull;
+    }
+    memset(batch, 0, sizeof(batch));
+    memset(expected_batch, 0, sizeof(expected_batch));
+    hashids_encode_one_batch(hashids, expected_batch, 32, batch_numbers,
+        lengthof(batch_numbers));
+    check(hashids_memo_encode_one_batch(memo, batch, 32, batch_numbers,
+            lengthof(batch_numbers)) == lengthof(batch_numbers)
+        && memcmp(batch, expected_batch, sizeof(batch)) == 0,
+        __LINE__, "hashids_memo_encode_one_batch() failed");
+
+    strcpy(batch + 50 * 32, "laHquq");
+    check(hashids_memo_decode_one_batch(memo, batch, 32,
+            lengthof(batch_numbers), decoded, valid)
+        == lengthof(batch_numbers) - 1, __LINE__,
+        "hashids_memo_decode_one_batch() failed");
+    for (i = 0, ok = 1; i < lengthof(batch_numbers); ++i) {
+        ok = ok && valid[i] == (hashids_decode_safe(hashids, batch + i * 32,
+                safe, lengthof(safe)) == 1)
+            && decoded[i] == (valid[i] ? safe[0] : 0);
+    }
+    hashids_memo_stats(memo, &stats);
+    check(ok && stats.duplicates >= 180, __LINE__,
+        "hashids_memo_decode_one_batch() disagrees with "
+        "hashids_decode_safe()");
+
+    /* concurrent use */
+    for (i = 0; i < lengthof(threads); ++i) {
+        pthread_create(&threads[i], NULL, memo_worker, memo);
+    }
+    for (i = 0, failed = 0; i < lengthof(threads); ++i) {
+        pthread_join(threads[i], &result);
+        failed += result != NULL;
+    }
+    hashids_memo_stats(memo, &stats);
+    check(!failed && stats.evictions, __LINE__, "concurrent memo use failed");
+
+    hashids_memo_free(memo);
+    hashids_free(hashids);
+}
+
+void
+test_dict(void)
+{
+    hashids_t *instances[2];
+    hashids_dict_t *dict;
+    char path[] = "/tmp/hashids-test-XXXXXX", expected[64], buffer[64];
+    unsigned long long number, decoded, count = 5000;
+    size_t i, length;
+    FILE *fp;
+    int fd, ok, ch;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        check(0, __LINE__, "mkstemp() failed");
+        return;
+    }
+    close(fd);
+
+    instances[0] = hashids_init("this is my salt");
+    instances[1] = hashids_init2("this is my salt", 8);
+
+    for (i = 0; i < lengthof(instances); ++i) {
+        check(hashids_dict_save(path, instances[i], count)
+            == HASHIDS_ERROR_OK, __LINE__, "hashids_dict_save() failed");
+
+        dict = hashids_dict_open(path);
+        check(dict && hashids_dict_count(dict) == count, __LINE__,
+            "hashids_dict_open() failed");
+        if (!dict) {
+            continue;
+        }
+
+        /* every hash, exactly as hashids_encode_one() has it */
+        for (number = 0, ok = 1; number < count; ++number) {
+            length = hashids_encode_one(instances[i], expected, number);
+            ok = ok && hashids_dict_encode(dict, buffer, number) == length
+                && strcmp(expected, buffer) == 0
+                && hashids_dict_decode(dict, buffer, &decoded) == 1
+                && decoded == number;
+        }
+        check(ok, __LINE__, "dictionary disagrees with hashids_encode_one()");
+
+        check(!hashids_dict_encode(dict, buffer, count)
+            && hashids_errno == HASHIDS_ERROR_INVALID_NUMBER, __LINE__,
+            "hashids_dict_encode() accepted a number past the count");
+
+        /* past the count, tampered & empty */
+        hashids_encode_one(instances[i], expected, count);
+        check(!hashids_dict_decode(dict, expected, &decoded)
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH, __LINE__,
+            "hashids_dict_decode() accepted a number past the count");
+        hashids_encode_one(instances[i], expected, 1234);
+        expected[0] = expected[0] == 'a' ? 'b' : 'a';
+        check(!hashids_dict_decode(dict, expected, &decoded), __LINE__,
+            "hashids_dict_decode() accepted a tampered hash");
+        check(!hashids_dict_decode(dict, "", &decoded), __LINE__,
+            "hashids_dict_decode() accepted an empty hash");
+
+        hashids_dict_close(dict);
+    }
+
+    /* flip a byte - the checksum must catch it */
+    fp = fopen(path, "r+b");
+    if (fp) {
+        fseek(fp, -3, SEEK_END);
+        ch = fgetc(fp);
+        fseek(fp, -3, SEEK_END);
+        fputc(ch ^ 0x20, fp);
+        fclose(fp);
+    }
+    dict = hashids_dict_open(path);
+    check(!dict && hashids_errno == HASHIDS_ERROR_INVALID_FILE, __LINE__,
+        "hashids_dict_open() accepted a corrupted file");
+    hashids_dict_close(dict);
+
+    unlink(path);
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+test_range(void)
+{
+    hashids_t *hashids, *padded, *small[2];
+    hashids_range_t *range;
+    static const unsigned long long starts[] = {0ull, 3844ull - 500,
+        238328ull - 100, 0xFFFFFFFFFFFFFFFFull - 150};
+    static const unsigned long long small_starts[] = {
+        1500000000000000000ull - 500, 0xFFFFFFFFFFFFFFFFull - 150};
+    char buffer[128], expected[128];
+    size_t i, j;
+    int ok;
+
+    hashids = hashids_init("this is my salt");
+    padded = hashids_init2("this is my salt", 12);
+    if (!hashids || !padded) {
+        check(0, __LINE__, "hashids_init() failed");
+        hashids_free(hashids);
+        hashids_free(padded);
+        return;
+    }
+
+    /* across digit count changes (62^2, 62^3) and up to the very end */
+    for (i = 0, ok = 1; i < lengthof(starts) * 2; ++i) {
+        range = hashids_range_init(i % 2 ? padded : hashids, starts[i / 2]);
+        if (!range) {
+            ok = 0;
+            break;
+        }
+        for (j = 0; j < 1000 && starts[i / 2] + j >= starts[i / 2]; ++j) {
+            hashids_encode_one(i % 2 ? padded : hashids, expected,
+                starts[i / 2] + j);
+            ok = ok && hashids_range_next(range, buffer) == strlen(expected)
+                && strcmp(buffer, expected) == 0;
+        }
+        ok = ok && (j == 1000 || hashids_range_next(range, buffer) == 0);
+        hashids_range_free(range);
+    }
+    check(ok, __LINE__, "hashids_range_next() disagrees with "
+        "hashids_encode_one()");
+
+    /* short final alphabets - 11 symbols for hex, 2 for the minimal one,
+       where a number takes up to 64 digits */
+    small[0] = hashids_init3("this is my salt", 0, "0123456789abcdef");
+    small[1] = hashids_init3("this is my salt", 0, "cfhistuCFHISTUab");
+    for (i = 0, ok = 1; i < lengthof(small); ++i) {
+        range = small[i] ? hashids_range_init(small[i], small_starts[i])
+            : NULL;
+        if (!range) {
+            ok = 0;
+            break;
+        }
+        for (j = 0; j < 1000 && small_starts[i] + j >= small_starts[i];
+            ++j) {
+            hashids_encode_one(small[i], expected, small_starts[i] + j);
+            ok = ok && hashids_range_next(range, buffer) == strlen(expected)
+                && strcmp(buffer, expected) == 0;
+        }
+        ok = ok && (j == 1000 || hashids_range_next(range, buffer) == 0);
+        hashids_range_free(range);
+    }
+    check(ok, __LINE__, "hashids_range_next() disagrees with "
+        "hashids_encode_one() on a short alphabet");
+
+    hashids_free(hashids);
+    hashids_free(padded);
+    hashids_free(small[0]);
+    hashids_free(small[1]);
+}
+
+void
+test_encoder(void)
+{
+    hashids_t *hashids, *padded, *instance;
+    hashids_encoder_t *encoder;
+    unsigned long long numbers[6], seed = 3;
+    char buffer[256], expected[256];
+    size_t i, j, prefix_count, suffix_count;
+    int ok;
+
+    hashids = hashids_init("this is my salt");
+    padded = hashids_init2("this is my salt", 40);
+    if (!hashids || !padded) {
+        check(0, __LINE__, "hashids_init() failed");
+        hashids_free(hashids);
+        hashids_free(padded);
+        return;
+    }
+
+    /* prefixes of 0 - 3 numbers, 1 - 3 numbers after them */
+    for (i = 0, ok = 1; i < 64; ++i) {
+        instance = i % 2 ? padded : hashids;
+        prefix_count = i / 2 % 4;
+        suffix_count = 1 + i / 8 % 3;
+        for (j = 0; j < prefix_count + suffix_count; ++j) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            numbers[j] = seed >> (j * 13 % 64);
+        }
+
+        encoder = hashids_encoder_init(instance, prefix_count, numbers);
+        if (!encoder) {
+            ok = 0;
+            break;
+        }
+        for (j = 0; j < 200; ++j) {
+            numbers[prefix_count] = j * 7919;
+            hashids_encode(instance, expected, prefix_count + suffix_count,
+                numbers);
+            ok = ok && hashids_encoder_encode(encoder, buffer, suffix_count,
+                numbers + prefix_count) == strlen(expected)
+                && strcmp(buffer, expected) == 0
+                && hashids_encoder_encode(encoder, NULL, suffix_count,
+                    numbers + prefix_count) > strlen(expected);
+        }
+        hashids_encoder_free(encoder);
+    }
+    check(ok, __LINE__, "hashids_encoder_encode() disagrees with "
+        "hashids_encode()");
+
+    hashids_free(hashids);
+    hashids_free(padded);
+}
+
+struct stream_numbers_t {
+    unsigned long long *numbers;
+    size_t count;
+    size_t passes;
+    size_t emitted;
+};
+
+size_t
+stream_read(void *ctx, size_t index, unsigned long long *numbers,
+    size_t numbers_max)
+{
+    struct stream_numbers_t *source = (struct stream_numbers_t *)ctx;
+    size_t count;
+
+    /* a handful at a time, bumping each number on the second pass if asked */
+    count = source->count - index < numbers_max ? source->count - index
+        : numbers_max;
+    count = count > 7 ? count - index % 7 : count;
+    memcpy(numbers, source->numbers + index, count * sizeof(*numbers));
+    if (source->passes && index == 0) {
+        --source->passes;
+        if (!source->passes && count) {
+            ++numbers[0];
+        }
+    }
+
+    return count;
+}
+
+int
+stream_emit(void *ctx, unsigned long long number)
+{
+    struct stream_numbers_t *target = (struct stream_numbers_t *)ctx;
+
+    if (target->emitted == target->count) {
+        return 1;
+    }
+    target->numbers[target->emitted++] = number;
+
+    return 0;
+}
+
+struct stream_chars_t {
+    char *data;
+    size_t length;
+    size_t size;
+    size_t writes;
+};
+
+int
+stream_write(void *ctx, const char *data, size_t length)
+{
+    struct stream_chars_t *sink = (struct stream_chars_t *)ctx;
+
+    ++sink->writes;
+    if (sink->length + length >= sink->size) {
+        return 1;
+    }
+    memcpy(sink->data + sink->length, data, length);
+    sink->length += length;
+    sink->data[sink->length] = '\0';
+
+    return 0;
+}
+
+void
+test_stream(void)
+{
+    hashids_t *instances[3];
+    hashids_stream_decoder_t *decoder;
+    struct stream_numbers_t source = {NULL, 0, 0, 0},
+        target = {NULL, 0, 0, 0};
+    struct stream_chars_t sink = {NULL, 0, 0, 0};
+    hashids_stream_source_t stream_source = {stream_read, NULL};
+    hashids_stream_sink_t stream_sink = {stream_write, NULL};
+    hashids_number_sink_t number_sink = {stream_emit, NULL};
+    static const size_t counts[] = {1, 2, 3, 7, 300, 20000};
+    unsigned long long seed = 5;
+    char *expected;
+    size_t i, j, k, length, fragment;
+    int ok;
+
+    instances[0] = hashids_init("this is my salt");
+    instances[1] = hashids_init2("this is my salt", 40);
+    instances[2] = hashids_init2("this is my salt", 5000);
+    source.numbers = (unsigned long long *)calloc(20000,
+        sizeof(unsigned long long));
+    target.numbers = (unsigned long long *)calloc(20000,
+        sizeof(unsigned long long));
+    expected = (char *)calloc(20000 * 18 + 8, 1);
+    sink.size = 20000 * 18 + 8;
+    sink.data = (char *)calloc(sink.size, 1);
+    stream_source.ctx = &source;
+    stream_sink.ctx = &sink;
+    number_sink.ctx = &target;
+
+    /* chunked output & fragmented input, against hashids_encode() */
+    for (i = 0, ok = 1; i < lengthof(instances) * lengthof(counts); ++i) {
+        source.count = counts[i % lengthof(counts)];
+        for (j = 0; j < source.count; ++j) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            source.numbers[j] = seed >> (seed % 64);
+        }
+        length = hashids_encode(instances[i / lengthof(counts)], expected,
+            source.count, source.numbers);
+
+        sink.length = 0;
+        ok = ok && hashids_encode_stream(instances[i / lengthof(counts)],
+            &stream_source, &stream_sink) == length
+            && sink.length == length && strcmp(sink.data, expected) == 0;
+
+        decoder = hashids_stream_decoder_init(instances[i / lengthof(counts)],
+            &number_sink);
+        target.count = source.count;
+        target.emitted = 0;
+        for (j = 0; decoder && j < length; j += fragment) {
+            fragment = 1 + (j * 31 + i) % 97;
+            fragment = fragment < length - j ? fragment : length - j;
+            ok = ok && hashids_stream_decoder_feed(decoder, expected + j,
+                fragment) == HASHIDS_ERROR_OK;
+        }
+        ok = ok && decoder
+            && hashids_stream_decoder_finish(decoder) == source.count
+            && memcmp(target.numbers, source.numbers,
+                source.count * sizeof(unsigned long long)) == 0;
+        hashids_stream_decoder_free(decoder);
+    }
+    check(ok, __LINE__, "streaming codec disagrees with hashids_encode()");
+    check(sink.writes > 20000 * 16 / 4096, __LINE__,
+        "hashids_encode_stream() did not write in chunks");
+
+    /* a source giving different numbers on the second pass */
+    source.count = 300;
+    source.passes = 2;
+    check(!hashids_encode_stream(instances[0], &stream_source, &stream_sink)
+        && hashids_errno == HASHIDS_ERROR_INVALID_NUMBER, __LINE__,
+        "hashids_encode_stream() missed a changing source");
+
+    /* the longest numbers of the shortest alphabet, well past a chunk */
+    hashids_free(instances[1]);
+    instances[1] = hashids_init3("this is my salt", 0, "cfhistuCFHISTUab");
+    source.count = 300;
+    for (j = 0; j < source.count; ++j) {
+        source.numbers[j] = 0xFFFFFFFFFFFFFFFFull;
+    }
+    sink.length = 0;
+    length = instances[1] ? hashids_encode(instances[1], expected,
+        source.count, source.numbers) : 0;
+    check(instances[1] && hashids_encode_stream(instances[1], &stream_source,
+        &stream_sink) == length && length > 300 * 64
+        && strcmp(sink.data, expected) == 0, __LINE__,
+        "hashids_encode_stream() of 64-digit numbers");
+
+    /* a sink giving up */
+    sink.size = 100;
+    check(!hashids_encode_stream(instances[0], &stream_source, &stream_sink)
+        && hashids_errno == HASHIDS_ERROR_IO, __LINE__,
+        "hashids_encode_stream() ignored a failing sink");
+
+    /* bad input fails until finish, then the decoder starts over */
+    decoder = hashids_stream_decoder_init(instances[0], &number_sink);
+    if (decoder) {
+        target.count = 4;
+        target.emitted = 0;
+        ok = hashids_stream_decoder_feed(decoder, "xR!", 3)
+            == HASHIDS_ERROR_INVALID_HASH
+            && hashids_stream_decoder_feed(decoder, "a", 1)
+                == HASHIDS_ERROR_INVALID_HASH
+            && !hashids_stream_decoder_finish(decoder)
+            && hashids_errno == HASHIDS_ERROR_INVALID_HASH
+            && !hashids_stream_decoder_finish(decoder);
+
+        source.numbers[0] = 12345;
+        hashids_encode(instances[0], expected, 1, source.numbers);
+        target.emitted = 0;
+        for (k = 0; expected[k]; ++k) {
+            ok = ok && hashids_stream_decoder_feed(decoder, expected + k, 1)
+                == HASHIDS_ERROR_OK;
+        }
+        ok = ok && hashids_stream_decoder_finish(decoder) == 1
+            && target.numbers[0] == 12345;
+        check(ok, __LINE__, "hashids_stream_decoder_finish() did not reset");
+        hashids_stream_decoder_free(decoder);
+    }
+
+    free(sink.data);
+    free(expected);
+    free(target.numbers);
+    free(source.numbers);
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+test_bounded(void)
+{
+    hashids_t *hashids, *padded, *instance;
+    unsigned long long numbers[16], decoded[16], safe[16], seed = 7;
+    char buffer[512];
+    struct testcase_t *testcase;
+    size_t i, j, length, count;
+    int ok;
+
+    /* every test case */
+    for (testcase = testcases, ok = 1; testcase->salt; ++testcase) {
+        instance = hashids_init3(testcase->salt, testcase->min_hash_length,
+            testcase->alphabet);
+        ok = ok && instance && hashids_decode_bounded(instance,
+            testcase->expected_hash, decoded, 16, 65536)
+            == testcase->numbers_count
+            && memcmp(decoded, testcase->numbers,
+                testcase->numbers_count * sizeof(decoded[0])) == 0;
+        hashids_free(instance);
+    }
+    check(ok, __LINE__, "hashids_decode_bounded() failed on a test case");
+
+    hashids = hashids_init("this is my salt");
+    padded = hashids_init2("this is my salt", 30);
+    if (!hashids || !padded) {
+        check(0, __LINE__, "hashids_init() failed");
+        hashids_free(hashids);
+        hashids_free(padded);
+        return;
+    }
+
+    /* the largest number still decodes, one more digit overflows */
+    numbers[0] = 0xFFFFFFFFFFFFFFFFull;
+    length = hashids_encode(hashids, buffer, 1, numbers);
+    check(hashids_decode_bounded(hashids, buffer, decoded, 1, 64) == 1
+        && decoded[0] == numbers[0], __LINE__,
+        "hashids_decode_bounded() failed on the largest number");
+    buffer[length] = buffer[length - 1];
+    buffer[length + 1] = '\0';
+    check(!hashids_decode_bounded(hashids, buffer, decoded, 1, 64)
+        && hashids_errno == HASHIDS_ERROR_INVALID_HASH, __LINE__,
+        "hashids_decode_bounded() accepted an overflowing number");
+
+    /* limits are inclusive */
+    for (i = 0; i < 5; ++i) {
+        numbers[i] = i * 1000003;
+    }
+    length = hashids_encode(padded, buffer, 5, numbers);
+    check(hashids_decode_bounded(padded, buffer, decoded, 5, length) == 5
+        && memcmp(decoded, numbers, 5 * sizeof(decoded[0])) == 0, __LINE__,
+        "hashids_decode_bounded() failed within its limits");
+    check(!hashids_decode_bounded(padded, buffer, decoded, 4, length)
+        && hashids_errno == HASHIDS_ERROR_LIMIT, __LINE__,
+        "hashids_decode_bounded() let too many numbers through");
+    check(!hashids_decode_bounded(padded, buffer, decoded, 5, length - 1)
+        && hashids_errno == HASHIDS_ERROR_LIMIT, __LINE__,
+        "hashids_decode_bounded() let a long hash through");
+
+    /* tampered hashes - same verdict as hashids_decode_safe() */
+    for (i = 0, ok = 1; i < 4000; ++i) {
+        instance = i % 2 ? padded : hashids;
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        count = 1 + (seed >> 60) % 4;
+        for (j = 0; j < count; ++j) {
+            numbers[j] = seed >> (j * 17 % 64);
+        }
+        length = hashids_encode(instance, buffer, count, numbers);
+        buffer[(seed >> 8) % length] =
+            instance->alphabet[(seed >> 20) % instance->alphabet_length];
+        if (i % 3 == 0) {
+            buffer[(seed >> 32) % length] =
+                instance->separators[(seed >> 40)
+                    % instance->separators_count];
+        }
+
+        j = hashids_decode_safe(instance, buffer, safe, 16);
+        ok = ok && hashids_decode_bounded(instance, buffer, decoded, 16,
+            sizeof(buffer)) == j
+            && memcmp(decoded, safe, j * sizeof(decoded[0])) == 0;
+    }
+    check(ok, __LINE__, "hashids_decode_bounded() disagrees with "
+        "hashids_decode_safe()");
+
+    hashids_free(hashids);
+    hashids_free(padded);
+}
+
+void
+test_decode_into(void)
+{
+    hashids_t *instances[3], *instance;
+    unsigned long long numbers[16], decoded[16], safe[16], seed = 11;
+    char buffer[512], charset[256];
+    struct testcase_t *testcase;
+    size_t i, j, length, count;
+    int ok;
+
+    /* every test case */
+    for (testcase = testcases, ok = 1; testcase->salt; ++testcase) {
+        instance = hashids_init3(testcase->salt, testcase->min_hash_length,
+            testcase->alphabet);
+        ok = ok && instance && hashids_decode_into(instance,
+            testcase->expected_hash, decoded, 16) == testcase->numbers_count
+            && memcmp(decoded, testcase->numbers,
+                testcase->numbers_count * sizeof(decoded[0])) == 0;
+        hashids_free(instance);
+    }
+    check(ok, __LINE__, "hashids_decode_into() failed on a test case");
+
+    instances[0] = hashids_init("this is my salt");
+    instances[1] = hashids_init2("this is my salt", 8);
+    instances[2] = hashids_init2("this is my salt", 30);
+    if (!instances[0] || !instances[1] || !instances[2]) {
+        check(0, __LINE__, "hashids_init() failed");
+        for (i = 0; i < lengthof(instances); ++i) {
+            hashids_free(instances[i]);
+        }
+        return;
+    }
+
+    /* too many for the array - the real count, and the first ones */
+    for (i = 0; i < 6; ++i) {
+        numbers[i] = i * 1000003;
+    }
+    hashids_encode(instances[1], buffer, 6, numbers);
+    check(hashids_decode_into(instances[1], buffer, decoded, 4) == 6
+        && hashids_errno == HASHIDS_ERROR_NEED_SPACE
+        && memcmp(decoded, numbers, 4 * sizeof(decoded[0])) == 0, __LINE__,
+        "hashids_decode_into() did not ask for more space");
+    check(hashids_decode_into(instances[1], buffer, decoded, 0) == 6
+        && hashids_errno == HASHIDS_ERROR_NEED_SPACE, __LINE__,
+        "hashids_decode_into() did not count without space");
+    check(hashids_decode_into(instances[1], buffer, decoded, 6) == 6
+        && hashids_errno == HASHIDS_ERROR_OK
+        && memcmp(decoded, numbers, 6 * sizeof(decoded[0])) == 0, __LINE__,
+        "hashids_decode_into() failed with just enough space");
+
+    /* tampered hashes & garbage - same verdict as hashids_decode_safe() */
+    for (i = 0, ok = 1; i < 6000; ++i) {
+        instance = instances[i % lengthof(instances)];
+        snprintf(charset, sizeof(charset), "%s%s%s", instance->alphabet,
+            instance->separators, instance->guards);
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+
+        if (i % 5 == 0) {
+            length = 1 + (seed >> 59);
+            for (j = 0; j < length; ++j) {
+                buffer[j] = charset[(seed >> (j % 48)) % strlen(charset)];
+            }
+            buffer[length] = '\0';
+        } else {
+            count = 1 + (seed >> 60) % 4;
+            for (j = 0; j < count; ++j) {
+                numbers[j] = (seed >> (j * 17 % 64)) >> (seed >> 58);
+            }
+            length = hashids_encode(instance, buffer, count, numbers);
+            if (i % 5 != 1) {
+                buffer[(seed >> 8) % length] =
+                    charset[(seed >> 20) % strlen(charset)];
+            }
+        }
+
+        j = hashids_decode_safe(instance, buffer, safe, 16);
+        ok = ok && hashids_decode_into(instance, buffer, decoded, 16) == j
+            && memcmp(decoded, safe, j * sizeof(decoded[0])) == 0;
+    }
+    check(ok, __LINE__, "hashids_decode_into() disagrees with "
+        "hashids_decode_safe()");
+
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+test_multi(void)
+{
+    hashids_t *instances[4], *many[65];
+    hashids_multi_t *multi;
+    unsigned long long numbers[8], decoded[8], expected[8], seed = 13;
+    char buffer[256], again[256];
+    size_t i, j, k, count, index, found;
+    int ok;
+
+    instances[0] = hashids_init("new salt");
+    instances[1] = hashids_init2("newer salt", 12);
+    instances[2] = hashids_init("old salt");
+    instances[3] = hashids_init3("new salt", 0, "0123456789abcdef");
+    multi = hashids_multi_init(instances, lengthof(instances));
+    if (!multi) {
+        check(0, __LINE__, "hashids_multi_init() failed");
+        for (i = 0; i < lengthof(instances); ++i) {
+            hashids_free(instances[i]);
+        }
+        return;
+    }
+
+    /* every configuration is recognized, garbage agrees with trying each */
+    for (i = 0, ok = 1; i < 4000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        k = i % lengthof(instances);
+        count = 1 + (seed >> 61);
+        for (j = 0; j < count; ++j) {
+            numbers[j] = (seed >> (j * 11 % 64)) >> (seed >> 58);
+        }
+        hashids_encode(instances[k], buffer, count, numbers);
+
+        if (i % 3 == 0) {
+            buffer[(seed >> 8) % strlen(buffer)] = "xY7!-\tf"[(seed >> 20) % 8];
+            for (k = 0, found = 0; k < lengthof(instances) && !found; ++k) {
+                found = hashids_decode_into(instances[k], buffer, expected,
+                    8);
+            }
+            ok = ok && hashids_multi_decode(multi, buffer, decoded, 8,
+                &index) == found
+                && (!found || (index + 1 == k && memcmp(decoded, expected,
+                    found * sizeof(decoded[0])) == 0));
+            continue;
+        }
+
+        /* an earlier config may give the same hash - short ones often do */
+        found = hashids_multi_decode(multi, buffer, decoded, 8, &index);
+        ok = ok && found && index <= k
+            && hashids_encode(instances[index], again, found, decoded)
+                == strlen(buffer)
+            && strcmp(again, buffer) == 0
+            && (index < k || (found == count && memcmp(decoded, numbers,
+                count * sizeof(decoded[0])) == 0));
+    }
+    check(ok, __LINE__, "hashids_multi_decode() picked the wrong config");
+
+    check(!hashids_multi_decode(multi, "", decoded, 8, &index)
+        && hashids_errno == HASHIDS_ERROR_INVALID_HASH, __LINE__,
+        "hashids_multi_decode() accepted an empty hash");
+
+    for (i = 0; i < lengthof(many); ++i) {
+        many[i] = instances[0];
+    }
+    check(!hashids_multi_init(many, lengthof(many))
+        && hashids_errno == HASHIDS_ERROR_LIMIT, __LINE__,
+        "hashids_multi_init() took too many configs");
+
+    hashids_multi_free(multi);
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+test_fanout(void)
+{
+    hashids_t *instances[5];
+    unsigned long long numbers[12], seed = 17;
+    char buffer[lengthof(instances) * 256], expected[256];
+    size_t i, j, k, count;
+    int ok;
+
+    instances[0] = hashids_init("tenant one");
+    instances[1] = hashids_init2("tenant two", 12);
+    instances[2] = hashids_init2("tenant three", 40);
+    instances[3] = hashids_init3("tenant four", 0, "0123456789abcdef");
+    instances[4] = hashids_init("");
+
+    /* every slot matches hashids_encode(), past the stack digits too */
+    for (i = 0, ok = 1; i < 2000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        count = 1 + i % lengthof(numbers);
+        for (j = 0; j < count; ++j) {
+            numbers[j] = (seed >> (j * 7 % 64)) >> (seed >> 58);
+        }
+
+        ok = ok && hashids_encode_fanout(instances, lengthof(instances),
+            buffer, 256, count, numbers) == lengthof(instances);
+        for (k = 0; k < lengthof(instances); ++k) {
+            hashids_encode(instances[k], expected, count, numbers);
+            ok = ok && strcmp(buffer + k * 256, expected) == 0;
+        }
+    }
+    check(ok, __LINE__,
+        "hashids_encode_fanout() differs from hashids_encode()");
+
+    numbers[0] = 1;
+    check(!hashids_encode_fanout(instances, lengthof(instances), buffer, 40,
+        1, numbers), __LINE__, "hashids_encode_fanout() overflowed a slot");
+
+    hashids_encode_fanout(instances, 2, buffer, 256, 0, numbers);
+    check(buffer[0] == '\0' && buffer[256] == '\0', __LINE__,
+        "hashids_encode_fanout() of nothing is not empty");
+
+    for (i = 0; i < lengthof(instances); ++i) {
+        hashids_free(instances[i]);
+    }
+}
+
+void
+test_pad(void)
+{
+    hashids_t *hashids, *plain;
+    static const size_t lengths[] = {5, 8, 22, 32, 33};
+    unsigned long long number, decoded, seed = 23;
+    char buffer[64], expected[64];
+    size_t i, k, length;
+    int ok;
+
+    for (k = 0, ok = 1; k < lengthof(lengths); ++k) {
+        hashids = hashids_init5("padded salt", lengths[k],
+            HASHIDS_DEFAULT_ALPHABET, NULL, HASHIDS_TABLE_PAD);
+        plain = hashids_init2("padded salt", lengths[k]);
+        if (!hashids || !plain) {
+            check(0, __LINE__, "hashids_init5() failed");
+            hashids_free(hashids);
+            hashids_free(plain);
+            return;
+        }
+
+        /* templates only when asked for & up to HASHIDS_PAD_TEMPLATE_MAX */
+        ok = ok && !plain->pad_templates
+            && !hashids->pad_templates == (lengths[k] > 32);
+
+        /* the same hashes as the padding loop, checked the same way */
+        for (i = 0; i < 3000; ++i) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            number = i < 100 ? i : seed >> (seed >> 58);
+
+            hashids_encode_one(hashids, buffer, number);
+            hashids_encode_one(plain, expected, number);
+            ok = ok && strcmp(buffer, expected) == 0
+                && hashids_decode_into(hashids, buffer, &decoded, 1) == 1
+                && decoded == number;
+
+            length = strlen(buffer);
+            buffer[(seed >> 8) % length] = "aZ0Ab"[(seed >> 20) % 5];
+            ok = ok && hashids_decode_into(hashids, buffer, &decoded, 1)
+                == hashids_decode_into(plain, buffer, &decoded, 1);
+        }
+
+        hashids_free(hashids);
+        hashids_free(plain);
+    }
+    check(ok, __LINE__, "padding templates differ from padding");
+}
+
 int
 main(int argc, char **argv)
 {
@@ -394,14 +2054,45 @@ test_end:
         }
     }
 
-    if (failures[0]) {
+    /* feature checks */
+    if (!fail || !fail_fast) {
+        fputs("\n", stdout);
+        test_init();
+        test_derive();
+        test_allocator();
+        test_registry();
+        test_file();
+        test_convenience();
+        test_big();
+        test_uuid();
+        test_batch();
+        test_parallel();
+        test_memo();
+        test_dict();
+        test_range();
+        test_encoder();
+        test_stream();
+        test_bounded();
+        test_decode_into();
+        test_multi();
+        test_fanout();
+        test_pad();
+    }
+
+    if (failures[0] || check_failures[0]) {
         fputs("\n\n", stdout);
         for (i = 0; failures[i]; ++i) {
             printf("%s\n", failures[i]);
             free(failures[i]);
         }
+        for (i = 0; check_failures[i]; ++i) {
+            printf("%s\n", check_failures[i]);
+            free(check_failures[i]);
+        }
     }
 
+    j += checks_count;
+    k += check_failures_count;
     printf("\n%lu samples, %lu failures\n", j, k);
 
     return k ? EXIT_FAILURE : EXIT_SUCCESS;
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hashids.hpp"
+
+/* compile-time configurations & their hashids_init3() twins */
+static constexpr char salt[] = "this is my salt";
+static constexpr char no_salt[] = "";
+static constexpr char long_salt[] = "this is a salt longer than most of the "
+    "alphabets it salts, so the per-number shuffle runs out of alphabet";
+static constexpr char hex_alphabet[] = "0123456789abcdef";
+static constexpr char odd_alphabet[] = "abcdefghijklmnopqrstuvwxyz0123";
+
+static unsigned long checks_count = 0, check_failures_count = 0;
+
+static void
+check(bool ok, int line, const char *description)
+{
+    ++checks_count;
+    std::fputc(ok ? '.' : 'F', stdout);
+
+    if (!ok) {
+        ++check_failures_count;
+        std::fprintf(stderr, "\n%s:%d: %s\n", __FILE__, line, description);
+    }
+}
+
+/* xorshift - the same tuples every run */
+static unsigned long long
+next(unsigned long long &seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+
+    return seed;
+}
+
+/* encode random tuples with both, decode the codec's output & mutations of
+   it with both */
+template <class Codec>
+static void
+test_codec(const char *salt, const char *alphabet, int line)
+{
+    hashids_t *hashids;
+    unsigned long long seed = 0x9E3779B97F4A7C15ull, numbers[12],
+        decoded_c[12], decoded[12];
+    char expected[512], actual[512];
+    size_t i, j, count, encoded, decoded_count;
+    bool encode_ok = true, decode_ok = true, size_ok = true;
+
+    hashids = hashids_init3(salt, Codec::min_hash_length, alphabet);
+    if (!hashids) {
+        check(false, line, "hashids_init3() failed");
+        return;
+    }
+    check(Codec::alphabet_length == hashids->alphabet_length, line,
+        "alphabet length differs from hashids_init3()");
+
+    for (i = 0; i < 4000; ++i) {
+        count = i % 7 == 0 ? next(seed) % 12 + 1 : 1;
+        for (j = 0; j < count; ++j) {
+            numbers[j] = next(seed) >> (next(seed) >> 58);
+        }
+        if (i < 100) {
+            numbers[0] = i;
+        }
+
+        hashids_encode(hashids, expected, count, numbers);
+        encoded = Codec::encode(actual, count, numbers);
+        encode_ok = encode_ok && std::strcmp(expected, actual) == 0;
+        size_ok = size_ok && encoded == std::strlen(actual)
+            && encoded < Codec::max_encoded_size(count);
+
+        /* the hash itself & a couple of mutations */
+        for (j = 0; j < 3; ++j) {
+            if (j) {
+                actual[next(seed) % encoded] =
+                    alphabet[next(seed) % std::strlen(alphabet)];
+            }
+            decoded_count = Codec::decode(actual, decoded, 12);
+            if (decoded_count != hashids_decode_safe(hashids, actual,
+                decoded_c, 12)
+                || std::memcmp(decoded, decoded_c,
+                    decoded_count * sizeof(decoded[0])) != 0) {
+                decode_ok = false;
+            }
+            if (!j && (decoded_count != count || std::memcmp(decoded,
+                numbers, count * sizeof(numbers[0])) != 0)) {
+                decode_ok = false;
+            }
+        }
+    }
+
+    check(encode_ok, line, "encode() differs from hashids_encode()");
+    check(size_ok, line, "encode() outgrows max_encoded_size()");
+    check(decode_ok, line, "decode() differs from hashids_decode_safe()");
+
+    /* too many numbers, garbage */
+    numbers[0] = 1; numbers[1] = 2; numbers[2] = 3;
+    Codec::encode(actual, 3, numbers);
+    check(Codec::decode(actual, decoded, 2) == 0, line,
+        "decode() past numbers_max");
+    check(Codec::decode("", decoded, 12) == 0
+        && Codec::decode(" ", decoded, 12) == 0, line,
+        "decode() of garbage");
+
+    hashids_free(hashids);
+}
+
+int
+main(void)
+{
+    test_codec<hashids::codec<salt>>(salt, HASHIDS_DEFAULT_ALPHABET,
+        __LINE__);
+    test_codec<hashids::codec<no_salt>>(no_salt, HASHIDS_DEFAULT_ALPHABET,
+        __LINE__);
+    test_codec<hashids::codec<salt, 8>>(salt, HASHIDS_DEFAULT_ALPHABET,
+        __LINE__);
+    test_codec<hashids::codec<salt, 32>>(salt, HASHIDS_DEFAULT_ALPHABET,
+        __LINE__);
+    test_codec<hashids::codec<salt, 40>>(salt, HASHIDS_DEFAULT_ALPHABET,
+        __LINE__);
+    test_codec<hashids::codec<long_salt, 12>>(long_salt,
+        HASHIDS_DEFAULT_ALPHABET, __LINE__);
+    test_codec<hashids::codec<salt, 0, hex_alphabet>>(salt, hex_alphabet,
+        __LINE__);
+    test_codec<hashids::codec<long_salt, 20, hex_alphabet>>(long_salt,
+        hex_alphabet, __LINE__);
+    test_codec<hashids::codec<salt, 16, odd_alphabet>>(salt, odd_alphabet,
+        __LINE__);
+
+    std::printf("\n%lu samples, %lu failures\n", checks_count,
+        check_failures_count);
+
+    return check_failures_count ? EXIT_FAILURE : EXIT_SUCCESS;
+}